@@ -0,0 +1,163 @@
+#include <cstring>
+
+#include "aggregator.h"
+
+// Si sommano slot per slot solo ciphertext con la stessa slot-map: con il batching due batch possono
+// assegnare gli stessi slot a sorgenti diverse, e la somma verrebbe demultiplata con la mappa sbagliata
+static bool same_slot_map(const std::vector<char>& map, const char* other, size_t other_size) {
+    return map.size() == other_size && memcmp(map.data(), other, other_size) == 0;
+}
+
+AggregationTable::AggregationTable(uint32_t window_msgs, std::chrono::milliseconds window_time)
+    : window_msgs(window_msgs), window_time(window_time) {}
+
+void AggregationTable::merge(const seal::Evaluator& evaluator, uint64_t key, AggregateResult& partial,
+                             std::vector<AggregateResult>& out) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = windows.find(key);
+    if (it != windows.end() &&
+        !same_slot_map(it->second.result.slot_map, partial.slot_map.data(), partial.slot_map.size())) {
+        // Slot-map diversa: la finestra aperta viene consegnata così com'è e ne inizia un'altra
+        out.push_back(std::move(it->second.result));
+        windows.erase(it);
+        it = windows.end();
+    }
+    if (it == windows.end()) {
+        // Primo contributo: la somma parziale viene spostata, nessuna copia del ciphertext
+        it = windows.emplace(key, Window{std::move(partial), std::chrono::steady_clock::now()}).first;
+    } else {
+        Window& w = it->second;
+        evaluator.add_inplace(w.result.sum, partial.sum);
+        w.result.count += partial.count;
+    }
+
+    if (it->second.result.count >= window_msgs) {
+        out.push_back(std::move(it->second.result));
+        windows.erase(it);
+    }
+}
+
+void AggregationTable::collect_expired(std::chrono::steady_clock::time_point now,
+                                       std::vector<AggregateResult>& out) {
+    std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    for (auto it = windows.begin(); it != windows.end();) {
+        if (now - it->second.opened >= window_time) {
+            out.push_back(std::move(it->second.result));
+            it = windows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AggregationTable::attach() {
+    std::lock_guard<std::mutex> lock(mtx);
+    attached++;
+}
+
+void AggregationTable::detach(std::vector<AggregateResult>& out) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (--attached > 0)
+        return;
+
+    for (auto& kv : windows)
+        out.push_back(std::move(kv.second.result));
+    windows.clear();
+}
+
+uint32_t AggregationTable::get_window_msgs() const {
+    return window_msgs;
+}
+
+std::chrono::milliseconds AggregationTable::get_window_time() const {
+    return window_time;
+}
+
+LcoreAggregator::LcoreAggregator(AggregationTable& table, seal::MemoryPoolHandle pool)
+    : table(table), pool(pool), last_collect(std::chrono::steady_clock::now()) {
+    table.attach();
+}
+
+LcoreAggregator::~LcoreAggregator() {
+    // Senza finish le somme parziali vanno perse, ma il conteggio dei lcore della tabella resta corretto
+    if (!finished) {
+        std::vector<AggregateResult> lost;
+        table.detach(lost);
+    }
+}
+
+void LcoreAggregator::add(const seal::Evaluator& evaluator, uint32_t flow, uint32_t message_id,
+                          const FlowRoute& route, const char* slot_map, size_t map_size,
+                          const seal::Ciphertext& ct, std::vector<AggregateResult>& out) {
+    uint32_t window = message_id / table.get_window_msgs();
+    uint64_t key = (static_cast<uint64_t>(flow) << 32) | window;
+
+    Partial& partial = partials[flow];
+
+    // Il flow è passato ad un'altra finestra, o il messaggio ha una slot-map diversa da quella della
+    // somma parziale: la somma precedente viene consegnata
+    if (partial.active && (partial.key != key || !same_slot_map(partial.result.slot_map, slot_map, map_size)))
+        flush(evaluator, partial, out);
+
+    if (!partial.active) {
+        partial.active = true;
+        partial.key = key;
+        partial.opened = std::chrono::steady_clock::now();
+        partial.result.count = 1;
+        partial.result.route = route;
+        partial.result.slot_map.assign(slot_map, slot_map + map_size);
+        // Dopo un merge la somma precedente è stata spostata nella tabella: si riparte dal pool del lcore
+        partial.result.sum = seal::Ciphertext(pool);
+        partial.result.sum = ct;
+    } else {
+        // Stessa slot-map della somma parziale (controllato sopra)
+        evaluator.add_inplace(partial.result.sum, ct);
+        partial.result.count++;
+    }
+
+    // Tutta la finestra è arrivata su questo lcore: non serve aspettare gli altri
+    if (partial.result.count >= table.get_window_msgs())
+        flush(evaluator, partial, out);
+}
+
+void LcoreAggregator::poll(const seal::Evaluator& evaluator, std::vector<AggregateResult>& out) {
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto it = partials.begin(); it != partials.end();) {
+        Partial& partial = it->second;
+        if (partial.active && now - partial.opened >= table.get_window_time())
+            flush(evaluator, partial, out);
+        // Flow senza finestra aperta: la voce viene liberata, si ricrea al prossimo messaggio
+        if (!partial.active)
+            it = partials.erase(it);
+        else
+            ++it;
+    }
+
+    if (now - last_collect >= std::chrono::milliseconds(1)) {
+        table.collect_expired(now, out);
+        last_collect = now;
+    }
+}
+
+void LcoreAggregator::finish(const seal::Evaluator& evaluator, std::vector<AggregateResult>& out) {
+    if (finished)
+        return;
+
+    for (auto& kv : partials) {
+        if (kv.second.active)
+            flush(evaluator, kv.second, out);
+    }
+    partials.clear();
+    table.detach(out);
+    finished = true;
+}
+
+void LcoreAggregator::flush(const seal::Evaluator& evaluator, Partial& partial, std::vector<AggregateResult>& out) {
+    table.merge(evaluator, partial.key, partial.result, out);
+    partial.active = false;
+}
@@ -0,0 +1,111 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "seal/seal.h"
+
+// Indirizzi usati per rispedire il risultato di un flow (già in network byte order)
+struct FlowRoute {
+    uint8_t src_mac[6];
+    uint8_t dst_mac[6];
+    uint32_t src_ip;
+    uint32_t dst_ip;
+    uint16_t src_port;
+};
+
+// message_id degli aggregati inviati: il lcore che invia nei bit alti e il contatore dei suoi invii nei
+// bassi. Finestre spezzate (timeout, slot-map diversa) e flow diversi non riusano mai lo stesso id
+constexpr unsigned AGG_ID_LCORE_BITS = 7;
+constexpr unsigned AGG_ID_COUNTER_BITS = 32 - AGG_ID_LCORE_BITS;
+
+inline uint32_t aggregate_message_id(unsigned lcore, uint32_t counter) {
+    return ((uint32_t)lcore << AGG_ID_COUNTER_BITS) | (counter & ((1u << AGG_ID_COUNTER_BITS) - 1));
+}
+
+// Ciphertext aggregato (o somma parziale di un lcore)
+struct AggregateResult {
+    uint32_t count = 0;             // Numero di messaggi sommati
+    FlowRoute route{};
+    std::vector<char> slot_map;     // Slot-map di tutti i messaggi della finestra (con una diversa ne inizia un'altra)
+    seal::Ciphertext sum;
+};
+
+// Finestre di aggregazione condivise tra i lcore. Ogni lcore accumula localmente (LcoreAggregator)
+// e consegna qui la propria somma parziale quando passa alla finestra successiva o quando questa
+// scade: il lock viene preso al massimo una volta per finestra per lcore, mai per ogni messaggio
+class AggregationTable {
+public:
+    // Una finestra si chiude dopo window_msgs messaggi oppure window_time dalla sua apertura
+    AggregationTable(uint32_t window_msgs, std::chrono::milliseconds window_time);
+
+    // Unisce una somma parziale alla sua finestra. Se la finestra è completa viene rimossa e aggiunta a out
+    void merge(const seal::Evaluator& evaluator, uint64_t key, AggregateResult& partial,
+               std::vector<AggregateResult>& out);
+
+    // Sposta in out le finestre scadute. Non blocca: se un altro lcore ha il lock ritorna subito
+    void collect_expired(std::chrono::steady_clock::time_point now, std::vector<AggregateResult>& out);
+
+    // Ogni LcoreAggregator si registra alla costruzione e si stacca alla fine: l'ultimo a staccarsi
+    // riceve in out tutte le finestre ancora aperte
+    void attach();
+    void detach(std::vector<AggregateResult>& out);
+
+    uint32_t get_window_msgs() const;
+    std::chrono::milliseconds get_window_time() const;
+
+private:
+    struct Window {
+        AggregateResult result;
+        std::chrono::steady_clock::time_point opened;
+    };
+
+    const uint32_t window_msgs;
+    const std::chrono::milliseconds window_time;
+    std::mutex mtx;
+    std::map<uint64_t, Window> windows;  // Chiave: (flow << 32) | indice della finestra
+    uint32_t attached = 0;               // LcoreAggregator non ancora staccati
+};
+
+// Somme parziali di un singolo lcore (non thread-safe, una istanza per lcore)
+class LcoreAggregator {
+public:
+    // Le somme parziali vengono allocate nel pool del lcore
+    LcoreAggregator(AggregationTable& table, seal::MemoryPoolHandle pool);
+    ~LcoreAggregator();
+
+    // Somma ct alla finestra (flow, message_id / window_msgs). Le finestre completate vengono aggiunte a out
+    void add(const seal::Evaluator& evaluator, uint32_t flow, uint32_t message_id, const FlowRoute& route,
+             const char* slot_map, size_t map_size, const seal::Ciphertext& ct,
+             std::vector<AggregateResult>& out);
+
+    // Da chiamare ad ogni iterazione del polling: consegna le somme parziali scadute e,
+    // al massimo una volta per millisecondo, raccoglie le finestre scadute della tabella
+    void poll(const seal::Evaluator& evaluator, std::vector<AggregateResult>& out);
+
+    // Alla chiusura del lcore: consegna le somme parziali aperte e si stacca dalla tabella (se è l'ultimo
+    // lcore riceve in out anche le finestre rimaste aperte)
+    void finish(const seal::Evaluator& evaluator, std::vector<AggregateResult>& out);
+
+private:
+    struct Partial {
+        bool active = false;
+        uint64_t key = 0;
+        std::chrono::steady_clock::time_point opened;
+        AggregateResult result;
+    };
+
+    void flush(const seal::Evaluator& evaluator, Partial& partial, std::vector<AggregateResult>& out);
+
+    AggregationTable& table;
+    seal::MemoryPoolHandle pool;
+    std::unordered_map<uint32_t, Partial> partials;  // Somma parziale della finestra aperta per flow (solo flow attivi)
+    std::chrono::steady_clock::time_point last_collect;
+    bool finished = false;
+};
+
+#endif
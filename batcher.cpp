@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstring>
+
+#include "batcher.h"
+
+TelemetryBatcher::TelemetryBatcher(size_t slot_count, std::chrono::microseconds flush_timeout)
+    : slot_count(slot_count), flush_timeout(flush_timeout) {
+    // Buffer pre allocati: il batch non supera mai slot_count campioni
+    samples.reserve(slot_count);
+    entries.reserve(slot_count);
+}
+
+bool TelemetryBatcher::add(uint16_t source_id, uint64_t value) {
+    if (samples.size() >= slot_count)
+        return false;
+
+    if (samples.empty())
+        first_sample_time = std::chrono::steady_clock::now();
+
+    samples.push_back({source_id, value});
+    return true;
+}
+
+bool TelemetryBatcher::ready() const {
+    if (samples.size() >= slot_count)
+        return true;
+    if (samples.empty())
+        return false;
+    return std::chrono::steady_clock::now() - first_sample_time >= flush_timeout;
+}
+
+bool TelemetryBatcher::empty() const {
+    return samples.empty();
+}
+
+size_t TelemetryBatcher::size() const {
+    return samples.size();
+}
+
+void TelemetryBatcher::flush(std::vector<char>& slot_map, std::vector<uint64_t>& slots) {
+    // Ordinamento stabile per sorgente: ogni sorgente occupa slot consecutivi e nella slot-map
+    // basta una voce per sorgente (l'ordine temporale dei campioni della stessa sorgente è mantenuto)
+    std::stable_sort(samples.begin(), samples.end(),
+                     [](const Sample& a, const Sample& b) { return a.source_id < b.source_id; });
+
+    slots.assign(slot_count, 0);
+    entries.clear();
+    for (size_t i = 0; i < samples.size(); i++) {
+        slots[i] = samples[i].value;
+        if (entries.empty() || entries.back().source_id != samples[i].source_id) {
+            entries.push_back({samples[i].source_id, static_cast<uint16_t>(i), 0});
+        }
+        entries.back().n_slots++;
+    }
+
+    SlotMapHeader hdr;
+    hdr.n_entries = static_cast<uint16_t>(entries.size());
+    slot_map.resize(sizeof(SlotMapHeader) + entries.size() * sizeof(SlotMapEntry));
+    memcpy(slot_map.data(), &hdr, sizeof(SlotMapHeader));
+    memcpy(slot_map.data() + sizeof(SlotMapHeader), entries.data(), entries.size() * sizeof(SlotMapEntry));
+
+    samples.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef BATCHER_H
+#define BATCHER_H
+
+#include "message.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Classe per il batching lato sender: accumula i campioni di telemetria di più sorgenti
+// negli slot di un unico ciphertext, invece di replicare lo stesso valore in tutti gli slot
+class TelemetryBatcher {
+public:
+    TelemetryBatcher(size_t slot_count, std::chrono::microseconds flush_timeout);
+
+    // Aggiunge un campione. Ritorna false se il batch è già pieno (va prima fatto flush)
+    bool add(uint16_t source_id, uint64_t value);
+
+    // Il batch va inviato se è pieno oppure se è scaduto il timeout dal primo campione
+    bool ready() const;
+    bool empty() const;
+    size_t size() const;
+
+    // Raggruppa i campioni per sorgente, scrive la slot-map serializzata (SlotMapHeader + voci)
+    // in slot_map e i valori da codificare in slots (slot_count elementi, quelli liberi a 0).
+    // Dopo il flush il batcher è vuoto e riutilizzabile (nessuna nuova allocazione)
+    void flush(std::vector<char>& slot_map, std::vector<uint64_t>& slots);
+
+private:
+    struct Sample {
+        uint16_t source_id;
+        uint64_t value;
+    };
+
+    size_t slot_count;
+    std::chrono::microseconds flush_timeout;
+    std::chrono::steady_clock::time_point first_sample_time;
+    std::vector<Sample> samples;
+    std::vector<SlotMapEntry> entries;
+};
+
+#endif
@@ -0,0 +1,393 @@
+// Microbenchmark delle fasi del sistema, senza DPU né rete: frammentazione (Message::send),
+// riassemblaggio (PacketAssembler), serializzazione dei ciphertext, somma omomorfica e datapath
+// completo del forwarder su un backend di I/O finto.
+// Ogni benchmark è parametrizzato dal grado del polinomio (la dimensione dei messaggi ne dipende);
+// la dimensione dei chunk è CHUNK_SIZE di message.h, riportata nei contatori di ogni risultato.
+//
+//   ./bench                                   tutti i benchmark
+//   ./bench --benchmark_filter=Assembler      solo il riassemblaggio
+//   ./bench --benchmark_format=json > a.json  per confrontare due build (tools/compare.py di Google Benchmark)
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+#include "seal/seal.h"
+
+#include "forwarder.h"
+#include "he_context.h"
+#include "message.h"
+#include "packet_assembler.h"
+#include "packet_io.h"
+#include "runtime_config.h"
+
+using namespace seal;
+
+// Gradi provati da tutti i benchmark
+#define DEGREE_ARGS Arg(2048)->Arg(4096)->Arg(8192)
+
+// Contesto SEAL con i parametri della configurazione e un grado diverso
+struct BenchContext {
+    SEALContext context;
+    KeyGenerator keygen;
+    PublicKey public_key;
+    Encryptor encryptor;
+    BatchEncoder encoder;
+
+    explicit BenchContext(size_t degree)
+        : context(make_parms(degree)), keygen(context), public_key(make_public_key(keygen)),
+          encryptor(context, public_key), encoder(context) {}
+
+    static EncryptionParameters make_parms(size_t degree)
+    {
+        EncryptionParameters parms(scheme_type::bfv);
+        parms.set_poly_modulus_degree(degree);
+        parms.set_coeff_modulus(CoeffModulus::BFVDefault(degree));
+        parms.set_plain_modulus(runtime_config().plain_modulus);
+        return parms;
+    }
+
+    static PublicKey make_public_key(KeyGenerator &keygen)
+    {
+        PublicKey pk;
+        keygen.create_public_key(pk);
+        return pk;
+    }
+
+    Ciphertext encrypt(uint64_t value)
+    {
+        std::vector<uint64_t> values(encoder.slot_count(), value);
+        Plaintext ptx;
+        encoder.encode(values, ptx);
+        Ciphertext ct;
+        encryptor.encrypt(ptx, ct);
+        return ct;
+    }
+};
+
+// Un contesto per grado, creato al primo uso (la generazione delle chiavi non va misurata)
+static BenchContext &bench_context(size_t degree)
+{
+    static std::map<size_t, std::unique_ptr<BenchContext>> contexts;
+    auto &ctx = contexts[degree];
+    if (!ctx)
+        ctx.reset(new BenchContext(degree));
+    return *ctx;
+}
+
+// Payload di un messaggio come lo manda il sender: slot-map vuota + ciphertext non compresso
+static const std::string &message_payload(size_t degree)
+{
+    static std::map<size_t, std::string> payloads;
+    std::string &payload = payloads[degree];
+    if (payload.empty()) {
+        Ciphertext ct = bench_context(degree).encrypt(42);
+        SlotMapHeader map_hdr{0};
+        payload.assign((const char *)&map_hdr, sizeof(map_hdr));
+        std::ostringstream ss;
+        ct.save(ss, compr_mode_type::none);
+        payload += ss.str();
+    }
+    return payload;
+}
+
+// Frammenti (TelemetryHeader + chunk) di un messaggio, come li costruisce Message::send
+static std::vector<std::vector<char>> make_fragments(const std::string &payload, uint32_t message_id)
+{
+    uint32_t total_size = payload.size();
+    uint32_t total_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    size_t hdr_size = fragment_header_size(total_chunks);
+    std::vector<std::vector<char>> fragments(total_chunks);
+    for (uint32_t i = 0; i < total_chunks; i++) {
+        uint16_t chunk_size = std::min<uint32_t>(CHUNK_SIZE, total_size - i * CHUNK_SIZE);
+        fragments[i].resize(hdr_size + chunk_size);
+        write_fragment_header(fragments[i].data(), message_id, total_chunks, i, total_size, chunk_size);
+        memcpy(fragments[i].data() + hdr_size, payload.data() + i * CHUNK_SIZE, chunk_size);
+    }
+    return fragments;
+}
+
+static void set_message_counters(benchmark::State &state, size_t message_size)
+{
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * message_size);
+    state.counters["msg_bytes"] = message_size;
+    state.counters["chunk_size"] = CHUNK_SIZE;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Frammentazione e invio: i datagrammi vanno a una socket UDP locale che non li legge mai
+// (il kernel li scarta a buffer pieno), quindi si misura la frammentazione più sendto
+// ---------------------------------------------------------------------------------------------
+static void BM_MessageSend(benchmark::State &state)
+{
+    const std::string &payload = message_payload(state.range(0));
+
+    int sink = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (sink < 0 || sock < 0 || bind(sink, (sockaddr *)&addr, sizeof(addr)) < 0 ||
+        getsockname(sink, (sockaddr *)&addr, &addr_len) < 0) {
+        state.SkipWithError("socket UDP locale non disponibile");
+        return;
+    }
+
+    Message msg(payload, 0);
+    msg.useSocket(sock, addr);
+    uint32_t id = 0;
+    for (auto _ : state) {
+        msg.setMessageId(id++);
+        if (msg.send() < 0) {
+            state.SkipWithError("sendto fallita");
+            break;
+        }
+    }
+    set_message_counters(state, payload.size());
+
+    close(sock);
+    close(sink);
+}
+BENCHMARK(BM_MessageSend)->DEGREE_ARGS;
+
+// ---------------------------------------------------------------------------------------------
+// Riassemblaggio: un messaggio completo per iterazione, con message_id sempre nuovo
+// ---------------------------------------------------------------------------------------------
+enum class Stream { InOrder, Reordered, Duplicated, Lossy };
+
+static void run_assembler(benchmark::State &state, Stream stream)
+{
+    const std::string &payload = message_payload(state.range(0));
+    std::vector<std::vector<char>> fragments = make_fragments(payload, 0);
+
+    // Ordine di arrivo dei frammenti, fisso per tutte le iterazioni
+    std::vector<size_t> order(fragments.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    switch (stream) {
+    case Stream::InOrder:
+        break;
+    case Stream::Reordered:
+        std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+        break;
+    case Stream::Duplicated:
+        // Ogni frammento arriva due volte
+        order.resize(2 * fragments.size());
+        for (size_t i = 0; i < fragments.size(); i++)
+            order[fragments.size() + i] = i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+        break;
+    case Stream::Lossy:
+        // Manca un frammento: il messaggio resta incompleto e viene liberato (come un timeout)
+        order.erase(order.begin() + order.size() / 2);
+        break;
+    }
+
+    PacketAssembler assembler(state.range(0));
+    uint32_t id = 0;
+    size_t completed = 0;
+    for (auto _ : state) {
+        for (size_t i : order)
+            memcpy(fragments[i].data(), &id, sizeof(id));  // message_id è il primo campo dell'header
+        for (size_t i : order) {
+            auto result = assembler.process_packet(fragments[i].data(), fragments[i].size());
+            completed += result.complete;
+            benchmark::DoNotOptimize(result);
+        }
+        // Un duplicato arrivato dopo il completamento ricrea il messaggio: va liberato come quello incompleto
+        if (stream == Stream::Lossy || stream == Stream::Duplicated)
+            assembler.reset(id);
+        id++;
+    }
+    set_message_counters(state, payload.size());
+    state.counters["fragments"] = order.size();
+    state.counters["completed"] = benchmark::Counter(completed, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_AssemblerInOrder(benchmark::State &state) { run_assembler(state, Stream::InOrder); }
+static void BM_AssemblerReordered(benchmark::State &state) { run_assembler(state, Stream::Reordered); }
+static void BM_AssemblerDuplicated(benchmark::State &state) { run_assembler(state, Stream::Duplicated); }
+static void BM_AssemblerLossy(benchmark::State &state) { run_assembler(state, Stream::Lossy); }
+BENCHMARK(BM_AssemblerInOrder)->DEGREE_ARGS;
+BENCHMARK(BM_AssemblerReordered)->DEGREE_ARGS;
+BENCHMARK(BM_AssemblerDuplicated)->DEGREE_ARGS;
+BENCHMARK(BM_AssemblerLossy)->DEGREE_ARGS;
+
+// ---------------------------------------------------------------------------------------------
+// Serializzazione dei ciphertext (senza compressione, come nel forwarder)
+// ---------------------------------------------------------------------------------------------
+static void BM_CiphertextLoad(benchmark::State &state)
+{
+    BenchContext &ctx = bench_context(state.range(0));
+    const std::string &payload = message_payload(state.range(0));
+    size_t map_size = parse_slot_map(payload.data(), payload.size());
+
+    MemoryPoolHandle pool = MemoryPoolHandle::New();
+    Ciphertext ct(pool);
+    for (auto _ : state) {
+        ct.load(ctx.context, (const seal_byte *)payload.data() + map_size, payload.size() - map_size);
+        benchmark::DoNotOptimize(ct.data());
+    }
+    set_message_counters(state, payload.size() - map_size);
+}
+BENCHMARK(BM_CiphertextLoad)->DEGREE_ARGS;
+
+static void BM_CiphertextSave(benchmark::State &state)
+{
+    Ciphertext ct = bench_context(state.range(0)).encrypt(42);
+    size_t size = ct.save_size(compr_mode_type::none);
+    std::vector<seal_byte> buffer(size);
+    for (auto _ : state) {
+        ct.save(buffer.data(), buffer.size(), compr_mode_type::none);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    set_message_counters(state, size);
+}
+BENCHMARK(BM_CiphertextSave)->DEGREE_ARGS;
+
+// ---------------------------------------------------------------------------------------------
+// Somma omomorfica con una costante: percorso generico e percorso con la costante pre calcolata
+// ---------------------------------------------------------------------------------------------
+static void run_add_plain(benchmark::State &state, bool fast)
+{
+    HEContext he(std::make_shared<const SEALContext>(bench_context(state.range(0)).context));
+    Ciphertext ct = bench_context(state.range(0)).encrypt(42);
+    for (auto _ : state) {
+        if (fast)
+            he.add_plain_number_fast(ct, 13291);
+        else
+            he.add_plain_number(ct, 13291);
+        benchmark::DoNotOptimize(ct.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_AddPlainNumber(benchmark::State &state) { run_add_plain(state, false); }
+static void BM_AddPlainNumberFast(benchmark::State &state) { run_add_plain(state, true); }
+BENCHMARK(BM_AddPlainNumber)->DEGREE_ARGS;
+BENCHMARK(BM_AddPlainNumberFast)->DEGREE_ARGS;
+
+// ---------------------------------------------------------------------------------------------
+// Datapath completo del forwarder (riassemblaggio, load, somma, save, costruzione degli header e
+// frammentazione della risposta) su un backend finto: rx_burst restituisce i frammenti di un
+// messaggio già pronti, tx_burst li accetta tutti senza inviarli
+// ---------------------------------------------------------------------------------------------
+class NullPacketIO : public PacketIO {
+public:
+    // Frame Ethernet/IPv4/UDP verso base_port con i frammenti di payload
+    explicit NullPacketIO(const std::vector<std::vector<char>> &fragments)
+    {
+        for (const auto &frag : fragments) {
+            std::vector<uint8_t> frame(sizeof(ether_header) + sizeof(iphdr) + sizeof(udphdr) + frag.size());
+            ether_header *eth = (ether_header *)frame.data();
+            memset(eth, 0, sizeof(*eth));
+            eth->ether_type = htons(ETHERTYPE_IP);
+            iphdr *ip = (iphdr *)(eth + 1);
+            memset(ip, 0, sizeof(*ip));
+            ip->version = 4;
+            ip->ihl = 5;
+            ip->protocol = IPPROTO_UDP;
+            ip->tot_len = htons(frame.size() - sizeof(ether_header));
+            udphdr *udp = (udphdr *)(ip + 1);
+            udp->source = htons(12345);
+            udp->dest = htons(runtime_config().base_port);
+            udp->len = htons(sizeof(udphdr) + frag.size());
+            udp->check = 0;
+            memcpy(udp + 1, frag.data(), frag.size());
+            frames.push_back(std::move(frame));
+        }
+    }
+
+    uint16_t rx_burst(uint16_t, uint16_t, Packet *pkts, uint16_t n) override
+    {
+        uint16_t nb_rx = 0;
+        while (nb_rx < n && next < frames.size()) {
+            pkts[nb_rx].data = frames[next].data();
+            pkts[nb_rx].len = frames[next].size();
+            pkts[nb_rx].handle = nullptr;
+            nb_rx++;
+            next++;
+        }
+        return nb_rx;
+    }
+
+    uint32_t tx_burst(uint16_t, uint16_t, Packet *, uint32_t n) override
+    {
+        tx_pkts += n;
+        return n;
+    }
+
+    bool alloc_bulk(uint16_t, uint16_t, Packet *pkts, uint32_t n) override
+    {
+        if (tx_buffers.size() < n)
+            tx_buffers.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            pkts[i].data = tx_buffers[i].data;
+            pkts[i].len = 0;
+            pkts[i].handle = nullptr;
+        }
+        return true;
+    }
+
+    void free_bulk(Packet *, uint32_t) override {}
+    int rx_queue_count(uint16_t, uint16_t) override { return 0; }
+    const char *name() const override { return "null"; }
+
+    // Il messaggio successivo riusa gli stessi frame con un altro message_id
+    void rewind(uint32_t message_id)
+    {
+        const size_t offset = sizeof(ether_header) + sizeof(iphdr) + sizeof(udphdr);
+        for (auto &frame : frames)
+            memcpy(frame.data() + offset, &message_id, sizeof(message_id));
+        next = 0;
+    }
+
+    uint64_t tx_pkts = 0;
+
+private:
+    struct Buffer {
+        uint8_t data[PACKET_IO_BUF_SIZE];
+    };
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<Buffer> tx_buffers;
+    size_t next = 0;
+};
+
+static void BM_ForwarderPipeline(benchmark::State &state)
+{
+    const std::string &payload = message_payload(state.range(0));
+    NullPacketIO io(make_fragments(payload, 0));
+
+    // Il Forwarder usa il contesto condiviso: quello del grado misurato, poi di nuovo quello di default
+    set_seal_context(std::make_shared<const SEALContext>(bench_context(state.range(0)).context));
+    runtime_config().poly_modulus_degree = state.range(0);
+    {
+        Forwarder fwd(io, nullptr, nullptr, 0);
+        uint32_t id = 0;
+        for (auto _ : state) {
+            io.rewind(id++);
+            while (fwd.poll(0, 0, 1, 0, BURST_SIZE) > 0) {
+            }
+        }
+    }
+    runtime_config().poly_modulus_degree = POLY_MODULUS_DEGREE;
+    set_seal_context(nullptr);
+
+    set_message_counters(state, payload.size());
+    state.counters["tx_pkts"] = benchmark::Counter(io.tx_pkts, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ForwarderPipeline)->DEGREE_ARGS;
+
+BENCHMARK_MAIN();
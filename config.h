@@ -19,4 +19,74 @@ constexpr uint16_t RX_QUEUE_SIZE = 128; // Dimensione della RX queue
 constexpr uint16_t TX_QUEUE_SIZE = 128; // Dimensione della TX queue
 constexpr uint32_t BURST_SIZE = 32;     // Numero massimo di pacchetti presi nel burst
 
+// Destino di un pacchetto ricevuto dal forwarder, per classe di traffico (vedi Forwarder::VerdictPolicy):
+// consume = elaborato e liberato (il frammento viene sostituito dalla risposta), forward = inoltrato
+// sulla porta di uscita, drop = liberato senza elaborarlo
+enum class TrafficVerdict : uint8_t { Consume, Forward, Drop };
+constexpr TrafficVerdict VERDICT_TELEMETRY = TrafficVerdict::Consume;  // forward elabora e inoltra anche l'originale
+constexpr TrafficVerdict VERDICT_OTHER = TrafficVerdict::Forward;      // ARP, traffico di fondo: consume equivale a drop
+
+// Aggregazione in-network nel forwarder
+constexpr uint32_t AGG_WINDOW_MSGS = 0;  // Messaggi sommati per finestra (0 = aggregazione disattivata)
+constexpr uint32_t AGG_WINDOW_MS = 100;  // Una finestra incompleta viene inviata dopo questo tempo
+
+// Riduzione degli slot nel forwarder: ogni gruppo di SLOT_SUM_GROUP slot consecutivi viene sommato nel
+// suo primo slot (con SLOT_SUM_GROUP = POLY_MODULUS_DEGREE tutti gli slot contengono la somma totale).
+// Potenza di 2, servono le Galois key (keygen --galois all, grado >= 4096). 0 = disattivata
+constexpr uint32_t SLOT_SUM_GROUP = 0;
+
+// Cut-through nel forwarder: i frammenti vengono inoltrati appena arrivano, correggendo sul posto i
+// coefficienti del ciphertext modificati dalla somma con la costante, invece di riassemblare il messaggio.
+// Solo senza aggregazione e riduzione degli slot (che hanno bisogno del ciphertext intero)
+constexpr bool CUT_THROUGH = false;
+// Cut-through: un messaggio ancora incompleto dopo questo tempo dal primo frammento viene scartato insieme
+// ai frammenti trattenuti (perdite di pacchetti)
+constexpr uint32_t STREAM_TIMEOUT_MS = 100;
+
+// Steering per message_id nel forwarder: ogni messaggio viene riassemblato dal lcore message_id % n_lcore
+// indipendentemente da come l'RSS distribuisce i frammenti. Serve quando il sender non manda tutti i
+// frammenti di un messaggio dalla stessa porta (costa una copia per ogni frammento ricevuto dal lcore sbagliato)
+constexpr bool STEER_BY_MESSAGE_ID = false;
+constexpr uint32_t STEER_RING_SIZE = 1024;   // Frammenti in attesa per lcore
+
+// Ciclo di polling del forwarder
+constexpr bool ADAPTIVE_BURST = true;        // Burst adattato ai pacchetti ricevuti, tra BURST_MIN e BURST_SIZE
+constexpr uint32_t BURST_MIN = 4;
+constexpr uint32_t POLL_WEIGHT_INGRESS = 4;  // Poll dell'ingress per ogni giro (la telemetria arriva da qui)
+constexpr uint32_t POLL_WEIGHT_EGRESS = 1;   // Poll dell'egress per ogni giro
+constexpr bool IDLE_BACKOFF = true;          // Pausa della CPU quando le code sono vuote
+constexpr uint32_t IDLE_SPIN_POLLS = 256;    // Giri a vuoto prima di iniziare le pause
+constexpr uint32_t IDLE_SLEEP_US = 0;        // Sleep massimo dopo le pause (0 = solo pause, latenza minima)
+
+// Admission control del forwarder: con più di ADMISSION_WATERMARK descrittori pieni nella coda RX
+// i messaggi nuovi vengono rifiutati al primo frammento (tutti i loro frammenti scartati, o inoltrati
+// senza elaborarli con ADMISSION_FORWARD), invece di perdere frammenti a caso di tutti i messaggi
+constexpr uint32_t ADMISSION_WATERMARK = 0;           // 0 = admission control disattivato
+constexpr bool ADMISSION_FORWARD = false;
+constexpr uint32_t ADMISSION_REJECT_SLOTS = 1024;     // message_id rifiutati ricordati per lcore (potenza di 2)
+
+// Code per tenant nel forwarder: i messaggi riassemblati vengono accodati per IP sorgente (e porta con
+// TENANT_BY_PORT) e passati all'elaborazione omomorfica con deficit round robin, al massimo
+// TENANT_HE_BUDGET per giro del ciclo di polling. Senza, ogni messaggio viene elaborato appena completo
+// e un sender che ne manda troppi toglie il lcore a tutti gli altri
+constexpr bool TENANT_SCHEDULING = false;
+constexpr bool TENANT_BY_PORT = false;
+constexpr uint32_t TENANT_QUANTUM = 65536;       // Byte aggiunti al deficit di un tenant ad ogni turno
+constexpr uint32_t TENANT_QUEUE_LEN = 64;        // Messaggi in coda per tenant (oltre vengono scartati)
+constexpr uint32_t TENANT_RATE_LIMIT = 0;        // Messaggi/s per tenant (0 = nessun limite)
+constexpr uint32_t TENANT_BURST = 32;            // Messaggi accettati di fila oltre il rate
+constexpr uint32_t TENANT_MAX = 1024;            // Tenant per lcore (i successivi condividono una coda)
+constexpr uint32_t TENANT_HE_BUDGET = 8;         // Messaggi elaborati per giro del ciclo di polling
+
+// Statistiche del forwarder
+constexpr uint32_t STATS_INTERVAL_MS = 0;        // Riga periodica con pps, scarti e messaggi (0 = disattivata)
+constexpr uint32_t STATS_SAMPLE_ROUNDS = 1024;   // Giri del ciclo di polling tra due letture della profondità della coda RX
+
+// Receiver: decifratura su un pool di worker
+constexpr uint32_t DECRYPT_WORKERS = 2;          // Thread di decifratura
+constexpr uint32_t DECRYPT_QUEUE_SIZE = 256;     // Messaggi completi in attesa (oltre vengono scartati)
+
+// Batching lato sender
+constexpr uint32_t BATCH_FLUSH_TIMEOUT_US = 1000; // Invio del batch incompleto dopo questo timeout
+
 #endif 
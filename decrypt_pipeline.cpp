@@ -0,0 +1,199 @@
+#include <chrono>
+#include <iostream>
+
+#include "decrypt_pipeline.h"
+#include "message.h"
+
+using namespace seal;
+
+// Un worker passa il suo blocco di righe all'OutputSink oltre questa dimensione o quando resta senza lavoro
+constexpr size_t OUTPUT_CHUNK_SIZE = 64 << 10;
+
+OutputSink::~OutputSink()
+{
+    close();
+}
+
+bool OutputSink::open(const std::string &target, size_t max_pending_bytes)
+{
+    max_pending = max_pending_bytes;
+    discard = (target == "none");
+    if (target == "-") {
+        out = stdout;
+    } else if (!discard) {
+        out = fopen(target.c_str(), "a");
+        if (!out) {
+            std::cerr << "Impossibile aprire " << target << std::endl;
+            return false;
+        }
+    }
+    stopping = false;
+    writer = std::thread(&OutputSink::writer_loop, this);
+    return true;
+}
+
+void OutputSink::close()
+{
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+    if (out && out != stdout)
+        fclose(out);
+    out = nullptr;
+}
+
+void OutputSink::write(std::string &chunk)
+{
+    if (chunk.empty())
+        return;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (discard || pending.size() + chunk.size() > max_pending) {
+            if (!discard)
+                dropped_bytes.fetch_add(chunk.size());
+            chunk.clear();
+            return;
+        }
+        pending += chunk;
+        wake = pending.size() >= OUTPUT_CHUNK_SIZE;
+    }
+    chunk.clear();
+    if (wake)
+        cv.notify_one();
+}
+
+void OutputSink::writer_loop()
+{
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        // Scrittura quando c'è un blocco pieno, altrimenti al massimo ogni 100 ms
+        cv.wait_for(lock, std::chrono::milliseconds(100),
+                    [this] { return stopping || pending.size() >= OUTPUT_CHUNK_SIZE; });
+        batch.swap(pending);
+        bool stop = stopping;
+        lock.unlock();
+
+        if (!batch.empty() && out) {
+            fwrite(batch.data(), 1, batch.size(), out);
+            fflush(out);
+        }
+        batch.clear();
+
+        lock.lock();
+        if (stop && pending.empty())
+            break;
+    }
+}
+
+DecryptPipeline::DecryptPipeline(const SEALContext &context, const SecretKey &secret_key,
+                                 OutputSink &sink, unsigned n_workers, size_t queue_size,
+                                 ResultsLogWriter *results_log)
+    : context(context), secret_key(secret_key), sink(sink), results_log(results_log), free_jobs(queue_size), ready_jobs(queue_size)
+{
+    for (size_t i = 0; i < queue_size; i++) {
+        jobs.emplace_back(new Job());
+        free_jobs.try_push(jobs.back().get());
+    }
+    for (unsigned i = 0; i < n_workers; i++)
+        workers.emplace_back(&DecryptPipeline::worker_loop, this);
+}
+
+DecryptPipeline::~DecryptPipeline()
+{
+    stop();
+}
+
+bool DecryptPipeline::submit(uint32_t message_id, std::vector<char> &data)
+{
+    Job *job;
+    if (!free_jobs.try_pop(job)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    job->message_id = message_id;
+    job->data.swap(data);
+    // Non può fallire: i job sono al massimo queue_size
+    ready_jobs.try_push(job);
+    return true;
+}
+
+void DecryptPipeline::stop()
+{
+    stopping.store(true);
+    for (auto &t : workers)
+        t.join();
+    workers.clear();
+}
+
+void DecryptPipeline::worker_loop()
+{
+    MemoryPoolHandle pool = MemoryPoolHandle::New();
+    Decryptor decryptor(context, secret_key);
+    BatchEncoder encoder(context);
+    Ciphertext ct(pool);
+    Plaintext ptx(pool);
+    std::vector<uint64_t> valori;
+    std::vector<SlotMapEntry> slot_map;
+    std::string out;
+    char line[160];
+
+    for (;;) {
+        Job *job;
+        if (!ready_jobs.try_pop(job)) {
+            // Senza lavoro: le righe accumulate vanno in uscita subito, poi una breve attesa
+            sink.write(out);
+            if (stopping.load())
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+
+        // Il payload inizia con la slot-map, seguita dal ciphertext
+        size_t map_size = parse_slot_map(job->data.data(), job->data.size(), &slot_map);
+        if (map_size == 0) {
+            snprintf(line, sizeof(line), "Slot-map non valida nel messaggio %u\n", job->message_id);
+            out += line;
+            free_jobs.try_push(job);
+            continue;
+        }
+
+        ct.load(context, reinterpret_cast<const seal_byte *>(job->data.data() + map_size), job->data.size() - map_size);
+        uint32_t message_id = job->message_id;
+        size_t size = job->data.size();
+        // Il buffer non serve più: il job torna subito disponibile per il thread RX
+        free_jobs.try_push(job);
+
+        decryptor.decrypt(ct, ptx);
+        encoder.decode(ptx, valori, pool);
+        decrypted.fetch_add(1, std::memory_order_relaxed);
+        if (results_log)
+            results_log->append(message_id, slot_map, valori);
+
+        snprintf(line, sizeof(line), "Messaggio %u completo (%zu bytes)\n", message_id, size);
+        out += line;
+        if (slot_map.empty()) {
+            snprintf(line, sizeof(line), "Valore decriptato: %lu, atteso: 13291\n", (unsigned long)valori[0]);
+            out += line;
+        } else {
+            // Demultiplazione: gli slot vengono restituiti alle rispettive sorgenti
+            for (const SlotMapEntry &entry : slot_map) {
+                if (entry.first_slot + entry.n_slots > valori.size())
+                    break;
+                snprintf(line, sizeof(line), "Sorgente %u: %u campioni, primo valore %lu, atteso: %u\n",
+                         entry.source_id, entry.n_slots, (unsigned long)valori[entry.first_slot],
+                         entry.source_id + 13291u);
+                out += line;
+            }
+        }
+
+        if (out.size() >= OUTPUT_CHUNK_SIZE)
+            sink.write(out);
+    }
+}
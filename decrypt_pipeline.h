@@ -0,0 +1,91 @@
+#ifndef DECRYPT_PIPELINE_H
+#define DECRYPT_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "seal/seal.h"
+
+#include "results_log.h"
+#include "ring.h"
+
+// Uscita testuale del receiver. I worker accodano blocchi di righe già formattate (il lock copre solo
+// la copia in memoria), un thread dedicato li scrive con una fwrite per blocco. Se lo scrittore resta
+// indietro di più di max_pending byte i blocchi nuovi vengono scartati invece di bloccare i worker
+class OutputSink {
+public:
+    OutputSink() = default;
+    ~OutputSink();
+
+    // target: "-" = stdout, "none" = niente output (per le misure), altrimenti il nome di un file
+    bool open(const std::string &target, size_t max_pending = 16 << 20);
+    void close();
+
+    // Accoda il contenuto di chunk (che viene svuotato)
+    void write(std::string &chunk);
+
+    uint64_t get_dropped_bytes() const { return dropped_bytes.load(); }
+
+private:
+    void writer_loop();
+
+    FILE *out = nullptr;
+    bool discard = false;
+    size_t max_pending = 0;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string pending;    // Protetto da mtx
+    bool stopping = false;  // Protetto da mtx
+    std::thread writer;
+    std::atomic<uint64_t> dropped_bytes{0};
+};
+
+// Pipeline di decifratura del receiver: il thread RX riassembla i messaggi e li passa con submit()
+// a un pool di worker, ognuno con Decryptor, BatchEncoder e pool di memoria SEAL propri. I job
+// (buffer del messaggio) sono preallocati e riciclati tramite due code senza lock: submit non alloca,
+// non prende lock e non si blocca mai; se i worker sono indietro il messaggio viene scartato e contato.
+// Con results_log i valori decifrati vengono anche salvati nel log binario
+class DecryptPipeline {
+public:
+    DecryptPipeline(const seal::SEALContext &context, const seal::SecretKey &secret_key,
+                    OutputSink &sink, unsigned n_workers, size_t queue_size,
+                    ResultsLogWriter *results_log = nullptr);
+    ~DecryptPipeline();
+
+    // Il contenuto di data viene scambiato con il buffer di un job libero (data resta utilizzabile)
+    bool submit(uint32_t message_id, std::vector<char> &data);
+
+    // Aspetta che i worker svuotino la coda e li termina
+    void stop();
+
+    uint64_t get_decrypted() const { return decrypted.load(); }
+    uint64_t get_dropped() const { return dropped.load(); }
+
+private:
+    struct Job {
+        uint32_t message_id;
+        std::vector<char> data;   // Slot-map + ciphertext
+    };
+
+    void worker_loop();
+
+    const seal::SEALContext &context;
+    const seal::SecretKey &secret_key;
+    OutputSink &sink;
+    ResultsLogWriter *results_log;
+    std::vector<std::unique_ptr<Job>> jobs;
+    BoundedRing<Job *> free_jobs;
+    BoundedRing<Job *> ready_jobs;
+    std::vector<std::thread> workers;
+    std::atomic_bool stopping{false};
+    std::atomic<uint64_t> decrypted{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+#endif
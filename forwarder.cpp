@@ -0,0 +1,772 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+#include "forwarder.h"
+#include "message.h"
+#include "param_set.h"
+#include "runtime_config.h"
+
+using namespace seal;
+
+std::atomic<long> total_load_us(0);
+std::atomic<long> total_add_us(0);
+std::atomic<long> total_save_us(0);
+std::atomic<long> he_op_count(0);
+
+uint16_t ipv4_checksum(const struct iphdr *ip)
+{
+    const uint16_t *words = (const uint16_t *)ip;
+    uint32_t sum = 0;
+    for (size_t i = 0; i < ip->ihl * 2u; i++)
+        sum += words[i];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+Forwarder::Forwarder(PacketIO &io, AggregationTable *agg_table, MessageSteering *steering, int worker_id)
+    : io(io), worker_id(worker_id), assembler(0, ciphertext_moduli(*seal_context())), steering(steering),
+      stats(&lcore_stats(worker_id))
+{
+    // Copia locale dei parametri usati per ogni pacchetto
+    const RuntimeConfig &cfg = runtime_config();
+    base_port = cfg.base_port;
+    n_ports = cfg.n_ports;
+    rx_port = cfg.rx_port;
+    lower_bound = cfg.lower_bound;
+    admission_watermark = cfg.admission_watermark;
+    policy.telemetry = cfg.verdict_telemetry;
+    policy.other = cfg.verdict_other;
+    if (admission_watermark > 0) {
+        rejected.assign(ADMISSION_REJECT_SLOTS, 0);
+        policy.rejected = cfg.admission_forward ? Verdict::Forward : Verdict::Drop;
+    }
+
+    // Buffer della risposta dimensionati una volta sola sul messaggio più grande dei parametri
+    dispatch_param_set(cfg.poly_modulus_degree, [this](auto params) {
+        using P = decltype(params);
+        if constexpr (P::fixed) {
+            ciphertext_buffer.reserve(P::max_message_bytes);
+            tx_pkts.reserve(P::max_chunks);
+        }
+    });
+
+    // Inizializzazione del contesto SEAL per ogni thread separato
+    he_ctx = new HEContext();
+    slot_sum_group = cfg.slot_sum_group;
+    if (slot_sum_group > 0 && !he_ctx->can_sum_slots(slot_sum_group)) {
+        printf("[THREAD%d] Galois key mancanti per slot-sum-group %zu (keygen --galois all): riduzione disattivata\n",
+               worker_id, slot_sum_group);
+        slot_sum_group = 0;
+    }
+    if (cfg.cut_through) {
+        if (agg_table || slot_sum_group > 0) {
+            printf("[THREAD%d] Cut-through incompatibile con aggregazione e slot-sum-group: disattivato\n", worker_id);
+        } else {
+            patcher = new StreamPatcher();
+            stream_timeout = std::chrono::milliseconds(cfg.stream_timeout_ms);
+            if (!patcher->init(*he_ctx, 13291)) {
+                printf("[THREAD%d] Parametri non adatti al cut-through: disattivato\n", worker_id);
+                delete patcher;
+                patcher = nullptr;
+            }
+        }
+    }
+    if (cfg.tenant_scheduling) {
+        // In cut-through non ci sono messaggi riassemblati da accodare
+        if (patcher) {
+            printf("[THREAD%d] Code per tenant non usate in cut-through\n", worker_id);
+        } else {
+            scheduler = new TenantScheduler(cfg.tenant_by_port, cfg.tenant_quantum, cfg.tenant_queue_len,
+                                            cfg.tenant_rate_limit, cfg.tenant_burst, cfg.tenant_max);
+            he_budget = cfg.tenant_he_budget;
+        }
+    }
+    if (agg_table)
+        lcore_agg = new LcoreAggregator(*agg_table, he_ctx->pool);
+}
+
+Forwarder::~Forwarder()
+{
+    delete scheduler;
+    delete patcher;
+    delete lcore_agg;
+    delete he_ctx;
+}
+
+// Ogni iterazione non viene usata sempre più memoria, ma viene riutilizzata la memoria già allocata
+// (rx_burst non alloca nuova memoria). La RAM usata aumenta solo all'arrivo del primo messaggio
+// (~2MB per thread), e viene poi riusata la stessa all'arrivo dei messaggi successivi.
+uint16_t Forwarder::poll(uint16_t in_port, uint16_t in_queue, uint16_t out_port, uint16_t out_queue, uint16_t burst_size)
+{
+    // Per ogni pacchetto disponibile (fino a burst_size) nella RX queue (in_queue) il backend
+    // restituisce un buffer già allocato (con DPDK gli mbuf del mempool creato all'avvio)
+    uint16_t nb_rx = io.rx_burst(in_port, in_queue, rx_pkts, burst_size);
+
+    // Con admission control serve la profondità della coda, ma solo se il burst è pieno: altrimenti la
+    // coda è stata svuotata. Se il backend non la fornisce un burst pieno conta come coda al limite
+    if (admission_watermark > 0) {
+        rx_depth = 0;
+        if (nb_rx == burst_size) {
+            int depth = io.rx_queue_count(in_port, in_queue);
+            rx_depth = (depth >= 0) ? depth : admission_watermark + 1;
+        }
+    }
+
+    /*if(nb_rx > 0){
+        printf("[THREAD%d] Ricevuti %u pacchetti\n", worker_id, nb_rx);
+    }*/
+
+    // Ogni pacchetto ha un verdetto: quelli da inoltrare vengono compattati all'inizio di rx_pkts
+    // (senza copie) e inviati con un solo tx_burst, gli altri liberati insieme con un solo free_bulk
+    uint16_t nb_fwd = 0;
+    uint16_t nb_free = 0;
+    uint64_t rx_bytes = 0;
+    uint64_t dropped = 0;
+    // I frammenti scartati dall'admission control e dal cut-through hanno i loro contatori (aggiornati da
+    // handle_fragment e stream_fragment)
+    const uint64_t admission_dropped = stats->get(STAT_DROP_ADMISSION);
+    const uint64_t stream_dropped = stats->get(STAT_DROP_STREAM);
+    for (uint16_t i = 0; i < nb_rx; i++) {
+        rx_bytes += rx_pkts[i].len;
+        streamed_in_place = false;
+        Verdict verdict = process_packet(rx_pkts[i], out_port, out_queue);
+        if (verdict == Verdict::Forward) {
+            fwd_streamed[nb_fwd] = streamed_in_place;
+            rx_pkts[nb_fwd++] = rx_pkts[i];
+        } else {
+            dropped += (verdict == Verdict::Drop);
+            free_pkts[nb_free++] = rx_pkts[i];
+        }
+    }
+
+    // Forward packets: quelli non accettati dalla TX queue (piena) vengono scartati invece di
+    // ritentare all'infinito, che bloccherebbe la ricezione
+    uint32_t sent = (nb_fwd > 0) ? io.tx_burst(out_port, out_queue, rx_pkts, nb_fwd) : 0;
+    uint64_t tx_bytes = 0;
+    uint32_t streamed = 0;
+    for (uint16_t i = 0; i < sent; i++) {
+        tx_bytes += rx_pkts[i].len;
+        streamed += fwd_streamed[i];
+    }
+    for (uint16_t i = sent; i < nb_fwd; i++)
+        free_pkts[nb_free++] = rx_pkts[i];
+
+    if (nb_rx > 0) {
+        stats->add(STAT_RX_PKTS, nb_rx);
+        stats->add(STAT_RX_BYTES, rx_bytes);
+        stats->add(STAT_TX_PKTS, sent);
+        stats->add(STAT_TX_BYTES, tx_bytes);
+        stats->add(STAT_FWD_PKTS, sent - streamed);
+        stats->add(STAT_STREAMED_FRAGS, streamed);
+        stats->add(STAT_DROP_POLICY, dropped - (stats->get(STAT_DROP_ADMISSION) - admission_dropped) -
+                                         (stats->get(STAT_DROP_STREAM) - stream_dropped));
+        stats->add(STAT_DROP_TX_FULL, nb_fwd - sent);
+    }
+
+    if (nb_free > 0)
+        io.free_bulk(free_pkts, nb_free);
+
+    return nb_rx;
+}
+
+Forwarder::Verdict Forwarder::process_packet(const Packet &pkt, uint16_t out_port, uint16_t out_queue)
+{
+    if (pkt.len < sizeof(struct ether_header) + sizeof(struct iphdr) + sizeof(struct udphdr))
+        return policy.other;
+
+    //Ethernet
+    const struct ether_header *eth = (const struct ether_header *)pkt.data;
+    if (eth->ether_type != htons(ETHERTYPE_IP))
+        return policy.other;
+
+    // IPv4 
+    const struct iphdr *ip = (const struct iphdr *)(eth + 1);
+    if (ip->protocol != IPPROTO_UDP)
+        return policy.other;
+
+    uint16_t ip_hdr_len = ip->ihl * 4;
+    if (sizeof(struct ether_header) + ip_hdr_len + sizeof(struct udphdr) > pkt.len)
+        return policy.other;
+
+    // UDP
+    const struct udphdr *udp =
+        (const struct udphdr *)((const uint8_t *)ip + ip_hdr_len);
+
+    const uint8_t *udp_payload = (const uint8_t *)(udp + 1);
+    //lunghezza dei singoli frammenti
+    uint16_t udp_len = ntohs(udp->len);
+    if (udp_len < sizeof(struct udphdr) || udp_payload + (udp_len - sizeof(struct udphdr)) > pkt.data + pkt.len)
+        return policy.other;
+    uint16_t udp_payload_len = udp_len - sizeof(struct udphdr);
+
+    //Non assemblare pacchetti non destinati al receiver (porte base_port..base_port+n_ports-1, un solo confronto)
+    uint16_t dst_port = ntohs(udp->dest);
+    if ((uint16_t)(dst_port - base_port) >= n_ports) {
+        //printf("[THREAD%d] Pacchetto con porta %u non assemblato\n", worker_id, dst_port);
+        return policy.other;
+    }
+
+    // Frammento scartato senza elaborarlo
+    if (policy.telemetry == Verdict::Drop)
+        return Verdict::Drop;
+
+    /*Non vanno modificati: nel mio test la DPU1 invia un pacchetto dal nsp0 
+    al nsp1, il quale viene intercettato dalla DPU2. Gli indirizzi di destinazione,
+    perciò, puntano già al nsp1 della DPU1! CAMBIO PERO' LA PORTA DI DESTINAZIONE UDP!*/
+    FlowRoute route;
+    memcpy(route.src_mac, eth->ether_shost, ETH_ALEN);
+    memcpy(route.dst_mac, eth->ether_dhost, ETH_ALEN);
+    route.src_ip = ip->saddr;  // IP sorgente fisso (nsp1, il sender originale)
+    route.dst_ip = ip->daddr;  // IP di destinazione del pacchetto originale (nsp0 = 192.168.28.10)
+    route.src_port = udp->source;
+
+    if (steering && udp_payload_len >= sizeof(TelemetryHeader) && udp_payload_len <= sizeof(steered.data)) {
+        // Il frammento appartiene al lcore proprietario del message_id: se non è questo gli viene copiato
+        TelemetryHeader tel_hdr;
+        memcpy(&tel_hdr, udp_payload, sizeof(TelemetryHeader));
+        uint16_t owner = steering->owner(tel_hdr.message_id);
+        if (owner != worker_id) {
+            steered.route = route;
+            steered.out_port = out_port;
+            steered.len = udp_payload_len;
+            memcpy(steered.data, udp_payload, udp_payload_len);
+            if (!steering->push(owner, steered))
+                stats->add(STAT_DROP_STEER_FULL, 1);
+            return policy.telemetry;
+        }
+    }
+
+    // Cut-through (senza admission control): il pacchetto ricevuto viene corretto e inoltrato com'è,
+    // cambiando solo la porta di destinazione come in send_fragments
+    if (patcher) {
+        Verdict verdict = stream_fragment((char *)udp_payload, udp_payload_len, route, out_port, out_queue, true);
+        if (verdict == Verdict::Forward) {
+            struct udphdr *udp_out = (struct udphdr *)udp;
+            udp_out->dest = htons(rx_port);
+            udp_out->check = 0;
+        }
+        return verdict;
+    }
+
+    // Devo fare cast da uint8_t a const char per come è scritto packet_assembler (in cui tengo char per semplicità)
+    // L'assembler copia il chunk nel suo buffer: dopo questa chiamata il pacchetto può essere liberato
+    if (!handle_fragment((const char *)udp_payload, udp_payload_len, route, out_port, out_queue))
+        return policy.rejected;
+    return policy.telemetry;
+}
+
+bool Forwarder::handle_fragment(const char *payload, uint16_t len, const FlowRoute &route,
+                                uint16_t out_port, uint16_t out_queue)
+{
+    if (admission_watermark > 0 && !admit(payload, len)) {
+        if (policy.rejected != Verdict::Forward)
+            stats->add(STAT_DROP_ADMISSION, 1);
+        return false;
+    }
+
+    auto result = assembler.process_packet(payload, len);
+    stats->set(STAT_REASSEMBLY_IN_FLIGHT, assembler.in_flight());
+    if (result.complete) {
+        //printf("[THREAD%d] Pacchetto %d assemblato\n", worker_id, result.message_id);
+        stats->add(STAT_COMPLETED_MESSAGES, 1);
+        if (!scheduler) {
+            process_message(result, route, out_port, out_queue);
+            return true;
+        }
+
+        // Il messaggio aspetta il turno del suo tenant (poll_scheduler)
+        pending.result = std::move(result);
+        pending.route = route;
+        pending.out_port = out_port;
+        pending.out_queue = out_queue;
+        TenantScheduler::EnqueueResult queued = scheduler->enqueue(pending);
+        if (queued == TenantScheduler::EnqueueResult::QueueFull)
+            stats->add(STAT_DROP_TENANT_QUEUE, 1);
+        else if (queued == TenantScheduler::EnqueueResult::RateLimited)
+            stats->add(STAT_DROP_TENANT_RATE, 1);
+        stats->set(STAT_TENANT_BACKLOG, scheduler->backlog());
+    }
+    return true;
+}
+
+uint32_t Forwarder::poll_scheduler()
+{
+    if (!scheduler)
+        return 0;
+
+    // Al massimo he_budget messaggi per giro: la ricezione non si ferma mentre le code si svuotano
+    uint32_t n = 0;
+    for (; n < he_budget && scheduler->dequeue(pending); n++)
+        process_message(pending.result, pending.route, pending.out_port, pending.out_queue);
+    if (n > 0)
+        stats->set(STAT_TENANT_BACKLOG, scheduler->backlog());
+    return n;
+}
+
+Forwarder::Verdict Forwarder::stream_fragment(char *payload, uint16_t len, const FlowRoute &route,
+                                              uint16_t out_port, uint16_t out_queue, bool in_place)
+{
+    bool complete = false;
+    StreamPatcher::Action action = patcher->process(payload, len, complete);
+    stats->set(STAT_REASSEMBLY_IN_FLIGHT, patcher->in_flight());
+    if (complete) {
+        stats->add(STAT_COMPLETED_MESSAGES, 1);
+        stats->add(STAT_HE_OPS, 1);
+    }
+
+    // Frammenti corretti sul posto: li conta poll dopo il tx_burst (STAT_STREAMED_FRAGS, non STAT_FWD_PKTS)
+    std::vector<std::vector<char>> &ready = patcher->released();
+    if (action == StreamPatcher::Action::Forward) {
+        if (!in_place)
+            ready.emplace_back(payload, payload + len);
+        else
+            streamed_in_place = true;
+    }
+    if (!ready.empty()) {
+        stats->add(STAT_STREAMED_FRAGS, ready.size());
+        send_raw_fragments(out_port, out_queue, route, ready);
+        ready.clear();
+    }
+
+    if (action == StreamPatcher::Action::Drop) {
+        stats->add(STAT_DROP_STREAM, 1);
+        return Verdict::Drop;
+    }
+    return (action == StreamPatcher::Action::Forward && in_place) ? Verdict::Forward : Verdict::Consume;
+}
+
+// Sotto sovraccarico scartare frammenti a caso lascia incompleti quasi tutti i messaggi, e il lavoro fatto
+// per riassemblarli è sprecato. Qui invece si decide per messaggio: quelli già iniziati continuano, quelli
+// nuovi vengono rifiutati finché la coda resta sopra la soglia, e il rifiuto vale per tutti i loro frammenti
+static_assert((ADMISSION_REJECT_SLOTS & (ADMISSION_REJECT_SLOTS - 1)) == 0, "ADMISSION_REJECT_SLOTS deve essere una potenza di 2");
+
+bool Forwarder::admit(const char *payload, uint16_t len)
+{
+    if (len < sizeof(TelemetryHeader))
+        return true;  // L'assembler lo ignora comunque
+
+    TelemetryHeader tel_hdr;
+    memcpy(&tel_hdr, payload, sizeof(TelemetryHeader));
+    uint32_t id = tel_hdr.message_id;
+
+    if (assembler.contains(id))
+        return true;
+    uint64_t &slot = rejected[id & (ADMISSION_REJECT_SLOTS - 1)];
+    if (slot == (uint64_t)id + 1)
+        return false;
+    if (rx_depth <= admission_watermark)
+        return true;
+
+    // Primo frammento di un messaggio nuovo con la coda sopra la soglia
+    slot = (uint64_t)id + 1;
+    stats->add(STAT_REJECTED_MESSAGES, 1);
+    return false;
+}
+
+void Forwarder::sample_rx_queue_depth(uint16_t port, uint16_t queue)
+{
+    // -1 se il backend non lo supporta (AF_PACKET)
+    int depth = io.rx_queue_count(port, queue);
+    stats->set(STAT_RX_QUEUE_DEPTH, depth > 0 ? depth : 0);
+}
+
+uint16_t Forwarder::poll_steered(const ForwardingQueues &queues, uint16_t burst_size)
+{
+    if (!steering)
+        return 0;
+
+    // Per l'admission control dei frammenti da altri lcore conta la coda di steering
+    if (admission_watermark > 0)
+        rx_depth = steering->backlog(worker_id);
+
+    // Al massimo un burst per giro, per non affamare le code RX
+    uint16_t i = 0;
+    for (; i < burst_size && steering->pop(worker_id, steered); i++) {
+        uint16_t out_queue = (steered.out_port == queues.egress.port_id) ? queues.egress.queue_id
+                                                                         : queues.ingress.queue_id;
+        if (patcher)
+            stream_fragment(steered.data, steered.len, steered.route, steered.out_port, out_queue, false);
+        else
+            handle_fragment(steered.data, steered.len, steered.route, steered.out_port, out_queue);
+    }
+    return i;
+}
+
+void Forwarder::process_message(const PacketAssembler::AssemblyResult &result, const FlowRoute &route,
+                                uint16_t out_port, uint16_t out_queue)
+{
+    auto start = std::chrono::high_resolution_clock::now(); // Timer iniziale per benchmark
+    
+    // Il payload inizia con la slot-map del batching, che viene rispedita invariata
+    size_t map_size = parse_slot_map(result.data.data(), result.data.size());
+    if (map_size == 0) {
+        printf("[THREAD%d] Slot-map non valida nel messaggio %u\n", worker_id, result.message_id);
+        stats->add(STAT_DROP_BAD_MESSAGE, 1);
+        return;
+    }
+
+    // Si ricrea oggetto SEAL partendo dal buffer. Se il sender usa la modalità simmetrica
+    // il ciphertext arriva "seeded" (secondo polinomio sostituito dal seed): load lo espande,
+    // per cui il ciphertext rispedito al receiver è sempre completo.
+    // Il ciphertext è sempre lo stesso per tutto il thread e vive nel pool del lcore: load
+    // alloca solo dal pool privato, che riusa la memoria liberata dal messaggio precedente
+    Ciphertext &ct = he_ctx->ct_buffer;
+    // Faccio casting in quanto result.data.data è di tipo char
+    ct.load(*he_ctx->context, 
+            reinterpret_cast<const seal::seal_byte*>(result.data.data() + map_size), 
+            result.data.size() - map_size);
+    auto after_load = std::chrono::high_resolution_clock::now();
+
+    // std::chrono::duration_cast<std::chrono::microseconds> restituisce un oggetto di tipo std::chrono::microseconds
+    // Facendo .count() ne prendo i microsecondi
+    auto load_us = std::chrono::duration_cast<std::chrono::microseconds>(after_load - start).count();
+    stats->add(STAT_HE_OPS, 1);
+
+    if (lcore_agg) {
+        // Modalità aggregazione: il ciphertext viene sommato alla finestra del suo flow (IP sorgente)
+        // e non viene rispedito singolarmente
+        lcore_agg->add(*he_ctx->evaluator, route.src_ip, result.message_id, route,
+                       result.data.data(), map_size, ct, aggregated);
+        if (result.message_id > lower_bound) {
+            total_load_us.fetch_add(load_us);
+            he_op_count.fetch_add(1);
+        }
+        send_aggregated(out_port, out_queue);
+        return;
+    }
+    
+    // Somma omomorfica con una costante (costante pre calcolata, vedi HEContext::add_plain_number_fast)
+    he_ctx->add_plain_number_fast(ct, 13291);
+    if (slot_sum_group > 0)
+        he_ctx->sum_slots(ct, slot_sum_group);
+    auto after_add = std::chrono::high_resolution_clock::now();
+    auto add_us = std::chrono::duration_cast<std::chrono::microseconds>(after_add - after_load).count();
+    
+    // Si prepara il buffer da inviare (senza compressione per risparmiare CPU, pesa solo 2 KB in più):
+    // slot-map originale seguita dal ciphertext risultante
+    auto ct_size = ct.save_size(seal::compr_mode_type::none);
+    ciphertext_buffer.resize(map_size + ct_size);
+    memcpy(ciphertext_buffer.data(), result.data.data(), map_size);
+    ct.save(ciphertext_buffer.data() + map_size, ct_size, seal::compr_mode_type::none);  
+
+    auto after_save = std::chrono::high_resolution_clock::now();
+    auto save_us = std::chrono::duration_cast<std::chrono::microseconds>(after_save - after_add).count();
+    
+    //printf("HE load:%ld add:%ld save:%ld \n", load_us, add_us, save_us);
+    
+    if (result.message_id > lower_bound) {
+        total_load_us.fetch_add(load_us);
+        total_add_us.fetch_add(add_us);
+        total_save_us.fetch_add(save_us);
+        he_op_count.fetch_add(1);
+    }
+    
+    // Frammentazione e invio indietro
+    send_fragments(out_port, out_queue, route, result.message_id, ciphertext_buffer);
+}
+
+uint8_t *Forwarder::write_frame_headers(uint8_t *pkt_data, const FlowRoute &route, uint16_t payload_size)
+{
+    //Ogni header viene scritto nel buffer partendo dall'offset 0
+    // Ethernet header
+    struct ether_header *eth_hdr = (struct ether_header *)pkt_data;
+    memcpy(eth_hdr->ether_shost, route.src_mac, ETH_ALEN);
+    memcpy(eth_hdr->ether_dhost, route.dst_mac, ETH_ALEN);
+    eth_hdr->ether_type = htons(ETHERTYPE_IP); //Dice che il payload ethernet contiene un pacchetto IPv4
+    
+    // IP header
+    struct iphdr *ip_hdr = (struct iphdr *)(eth_hdr + 1); //Scorro nel buffer pkt_data...
+    memset(ip_hdr, 0, sizeof(struct iphdr));
+    ip_hdr->version = 4;
+    ip_hdr->ihl = 5;
+    ip_hdr->tos = 0;
+    ip_hdr->tot_len = htons(sizeof(struct iphdr) + 
+                            sizeof(struct udphdr) + 
+                            payload_size);
+    ip_hdr->id = 0;  //Non uso la frammentazione a livello IP
+    ip_hdr->frag_off = 0;
+    ip_hdr->ttl = 64; //Standard
+    ip_hdr->protocol = IPPROTO_UDP;
+    ip_hdr->saddr = route.src_ip;
+    ip_hdr->daddr = route.dst_ip;
+    ip_hdr->check = 0;
+    ip_hdr->check = ipv4_checksum(ip_hdr);
+    
+    // UDP header
+    /*Potrei lasciare invariata la porta di destinazione, ma ho visto che se lo faccio il receiver
+    intercetta i messaggi inviati dalla DPU1 prima che la DPU2 li elabori*/
+    struct udphdr *udp_hdr = (struct udphdr *)(ip_hdr + 1);
+    udp_hdr->source = route.src_port;
+    udp_hdr->dest = htons(rx_port);
+    udp_hdr->len = htons(sizeof(struct udphdr) + payload_size);
+    udp_hdr->check = 0;  // Opzionale per UDP
+    
+    return (uint8_t *)(udp_hdr + 1);
+}
+
+void Forwarder::transmit(uint16_t out_port, uint16_t out_queue, uint32_t n)
+{
+    // Invia tutti i chunk sulla porta di USCITA (out_port = P1)
+    // Il pacchetto arriva su P0, viene elaborato, e esce su P1 verso DPU1:P1
+    uint32_t sent = io.tx_burst(out_port, out_queue, tx_pkts.data(), n);
+    if (sent < n) {
+        printf("[THREAD%d] Errore invio di %u chunk\n", worker_id, n - sent);
+        stats->add(STAT_DROP_TX_FULL, n - sent);
+        io.free_bulk(tx_pkts.data() + sent, n - sent);
+    }
+    uint64_t tx_bytes = 0;
+    for (uint32_t i = 0; i < sent; i++)
+        tx_bytes += tx_pkts[i].len;
+    stats->add(STAT_TX_PKTS, sent);
+    stats->add(STAT_TX_BYTES, tx_bytes);
+}
+
+// Non uso la classe Message in quanto essa è fatta per l'invio con uso di socket
+void Forwarder::send_fragments(uint16_t out_port, uint16_t out_queue, const FlowRoute &route,
+                               uint32_t message_id, const std::vector<seal::seal_byte> &payload)
+{
+    uint32_t total_size = payload.size();
+    uint32_t total_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    //printf("[THREAD%d] Frammentazione in %u chunks\n", worker_id, total_chunks);
+    
+    // Alloca tutti i buffer in una volta (bulk alloc), per evitare di allocarli per ogni chunk
+    tx_pkts.resize(total_chunks);
+    if (!io.alloc_bulk(out_port, out_queue, tx_pkts.data(), total_chunks)) {
+        printf("[THREAD%d] Errore bulk alloc per i pacchetti di risposta\n", worker_id);
+        stats->add(STAT_DROP_ALLOC, 1);
+        return;
+    }
+    
+    // Telemetry header (si trova in message.h), esteso oltre 65535 chunk
+    size_t hdr_size = fragment_header_size(total_chunks);
+    
+    for (uint32_t chunk_idx = 0; chunk_idx < total_chunks; chunk_idx++) {
+        // Calcola dimensione del chunk corrente
+        uint32_t offset = chunk_idx * CHUNK_SIZE;
+        uint16_t current_chunk_size = std::min((uint32_t)CHUNK_SIZE, total_size - offset);
+        
+        // Calcolo dimensioni
+        uint16_t payload_size = hdr_size + current_chunk_size;
+        uint16_t total_pkt_size = sizeof(struct ether_header) + 
+                                 sizeof(struct iphdr) + 
+                                 sizeof(struct udphdr) + 
+                                 payload_size;
+        
+        // Costruisco il pacchetto
+        char *payload_ptr = (char *)write_frame_headers(tx_pkts[chunk_idx].data, route, payload_size);
+        
+        // Payload: header telemetria + chunk dati (Come in message.cpp)
+        write_fragment_header(payload_ptr, message_id, total_chunks, chunk_idx, total_size, current_chunk_size);
+        // Tutti i chunk tranne l'ultimo sono pieni: copia a lunghezza costante
+        if (current_chunk_size == CHUNK_SIZE)
+            memcpy(payload_ptr + hdr_size, payload.data() + offset, CHUNK_SIZE);
+        else
+            memcpy(payload_ptr + hdr_size, payload.data() + offset, current_chunk_size);
+        
+        // Imposta lunghezza pacchetto
+        tx_pkts[chunk_idx].len = total_pkt_size;
+    }
+
+    transmit(out_port, out_queue, total_chunks);
+    
+    //printf("[THREAD%d] Tutti i %u chunks inviati\n", worker_id, total_chunks);
+}
+
+void Forwarder::send_raw_fragments(uint16_t out_port, uint16_t out_queue, const FlowRoute &route,
+                                   const std::vector<std::vector<char>> &fragments)
+{
+    uint32_t n = fragments.size();
+    tx_pkts.resize(n);
+    if (!io.alloc_bulk(out_port, out_queue, tx_pkts.data(), n)) {
+        printf("[THREAD%d] Errore bulk alloc per i frammenti in cut-through\n", worker_id);
+        stats->add(STAT_DROP_ALLOC, 1);
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t payload_size = fragments[i].size();
+        uint8_t *payload_ptr = write_frame_headers(tx_pkts[i].data, route, payload_size);
+        memcpy(payload_ptr, fragments[i].data(), payload_size);
+        tx_pkts[i].len = sizeof(struct ether_header) + sizeof(struct iphdr) + sizeof(struct udphdr) + payload_size;
+    }
+    transmit(out_port, out_queue, n);
+}
+
+// worker_id < STATS_MAX_LCORES (controllato all'avvio) deve stare nei bit del lcore dell'id degli aggregati
+static_assert((1u << AGG_ID_LCORE_BITS) >= STATS_MAX_LCORES, "AGG_ID_LCORE_BITS troppo piccolo per STATS_MAX_LCORES");
+
+// La somma con la costante viene fatta una sola volta sul ciphertext aggregato invece che su ogni messaggio
+void Forwarder::send_aggregated(uint16_t out_port, uint16_t out_queue)
+{
+    for (auto &agg : aggregated) {
+        he_ctx->add_plain_number_fast(agg.sum, 13291);
+        if (slot_sum_group > 0)
+            he_ctx->sum_slots(agg.sum, slot_sum_group);
+
+        auto ct_size = agg.sum.save_size(seal::compr_mode_type::none);
+        ciphertext_buffer.resize(agg.slot_map.size() + ct_size);
+        memcpy(ciphertext_buffer.data(), agg.slot_map.data(), agg.slot_map.size());
+        agg.sum.save(ciphertext_buffer.data() + agg.slot_map.size(), ct_size, seal::compr_mode_type::none);
+
+        send_fragments(out_port, out_queue, agg.route, aggregate_message_id(worker_id, agg_sent++), ciphertext_buffer);
+    }
+    aggregated.clear();
+}
+
+void Forwarder::poll_timers(uint16_t out_port, uint16_t out_queue)
+{
+    // Cut-through e aggregazione si escludono
+    if (patcher) {
+        size_t expired = patcher->expire(std::chrono::steady_clock::now(), stream_timeout);
+        if (expired > 0) {
+            stats->add(STAT_STREAM_EXPIRED, expired);
+            stats->set(STAT_REASSEMBLY_IN_FLIGHT, patcher->in_flight());
+        }
+        return;
+    }
+    if (!lcore_agg)
+        return;
+
+    lcore_agg->poll(*he_ctx->evaluator, aggregated);
+    send_aggregated(out_port, out_queue);
+}
+
+void Forwarder::flush_aggregates(uint16_t out_port, uint16_t out_queue)
+{
+    if (!lcore_agg)
+        return;
+
+    lcore_agg->finish(*he_ctx->evaluator, aggregated);
+    send_aggregated(out_port, out_queue);
+}
+
+// Burst di una direzione: raddoppia quando rx_burst riempie tutto il burst (c'è coda), dimezza quando
+// riceve meno di un quarto. A basso carico si chiedono pochi descrittori per volta, a pieno carico
+// si torna al burst massimo senza perdere throughput
+class AdaptiveBurst {
+public:
+    AdaptiveBurst(uint16_t min, uint16_t max) : min(min), max(max), current(max) {}
+
+    uint16_t size() const { return current; }
+
+    void update(uint16_t nb_rx)
+    {
+        if (nb_rx == current)
+            current = std::min<uint16_t>(current * 2, max);
+        else if (nb_rx < current / 4)
+            current = std::max<uint16_t>(current / 2, min);
+    }
+
+private:
+    uint16_t min, max, current;
+};
+
+// Hint alla CPU dentro uno spin loop (come rte_pause): libera risorse per l'altro hyperthread e riduce i consumi
+static inline void cpu_pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Poll di una direzione fino a weight volte (meno se la coda si svuota). Ritorna i pacchetti ricevuti
+static uint32_t poll_direction(Forwarder &fwd, uint16_t in_port, uint16_t in_queue, uint16_t out_port,
+                               uint16_t out_queue, uint32_t weight, AdaptiveBurst &burst)
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < weight; i++) {
+        // Il burst richiesto va salvato prima di update, che lo raddoppia dopo un burst pieno
+        const uint16_t want = burst.size();
+        uint16_t nb_rx = fwd.poll(in_port, in_queue, out_port, out_queue, want);
+        burst.update(nb_rx);
+        total += nb_rx;
+        if (nb_rx < want)
+            break;
+    }
+    return total;
+}
+
+void run_forwarding_loop(Forwarder &fwd, const ForwardingQueues &queues, uint16_t burst_size,
+                         const std::atomic_bool &exit_request)
+{
+    const RuntimeConfig &cfg = runtime_config();
+    uint16_t burst_min = cfg.adaptive_burst ? std::min<uint16_t>(cfg.burst_min, burst_size) : burst_size;
+    AdaptiveBurst ingress_burst(burst_min, burst_size);
+    AdaptiveBurst egress_burst(burst_min, burst_size);
+
+    uint32_t rounds = 0;
+    uint32_t idle_polls = 0;  // Giri consecutivi senza niente da fare
+    uint32_t sleep_us = 0;    // Sleep corrente del backoff (raddoppia fino a idle_sleep_us)
+
+    // loop until exit is requested!
+    while (!exit_request.load())
+    {
+        uint32_t work = 0;
+
+        /* from ingress to egress */
+        work += poll_direction(fwd, queues.ingress.port_id, queues.ingress.queue_id,
+                               queues.egress.port_id, queues.egress.queue_id,
+                               cfg.poll_weight_ingress, ingress_burst);
+        /* from egress to ingress */
+        work += poll_direction(fwd, queues.egress.port_id, queues.egress.queue_id,
+                               queues.ingress.port_id, queues.ingress.queue_id,
+                               cfg.poll_weight_egress, egress_burst);
+
+        // Frammenti ricevuti dagli altri lcore (steering per message_id)
+        work += fwd.poll_steered(queues, burst_size);
+
+        // Elaborazione omomorfica dei messaggi in coda per tenant
+        work += fwd.poll_scheduler();
+
+        // Chiusura delle finestre di aggregazione scadute (anche senza traffico in arrivo)
+        fwd.poll_timers(queues.egress.port_id, queues.egress.queue_id);
+
+        if (++rounds % STATS_SAMPLE_ROUNDS == 0)
+            fwd.sample_rx_queue_depth(queues.ingress.port_id, queues.ingress.queue_id);
+
+        if (work > 0 || !cfg.idle_backoff) {
+            idle_polls = 0;
+            sleep_us = 0;
+            continue;
+        }
+
+        // Code vuote: dopo idle_spin_polls giri si cede la CPU. Le pause costano qualche decina di
+        // cicli e non aggiungono latenza misurabile, gli sleep solo se abilitati (idle_sleep_us > 0)
+        if (++idle_polls < cfg.idle_spin_polls)
+            continue;
+        if (cfg.idle_sleep_us == 0 || idle_polls < 2 * cfg.idle_spin_polls) {
+            cpu_pause();
+            continue;
+        }
+        sleep_us = std::min(std::max(sleep_us * 2, 1u), cfg.idle_sleep_us);
+        std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+    }
+
+    // Le finestre ancora aperte vengono inviate invece di andare perse
+    fwd.flush_aggregates(queues.egress.port_id, queues.egress.queue_id);
+}
+
+void print_he_benchmark()
+{
+    // Stampa medie benchmark 
+    long count = he_op_count.load();
+    if (count > 0) {
+        std::cout << "Operazioni totali: " << count << std::endl;
+        std::cout << "Media load:  " << (total_load_us.load() / count) << " µs" << std::endl;
+        std::cout << "Media add:   " << (total_add_us.load() / count) << " µs" << std::endl;
+        std::cout << "Media save:  " << (total_save_us.load() / count) << " µs" << std::endl;
+        std::cout << "Media totale: " << ((total_load_us.load() + total_add_us.load() + total_save_us.load()) / count) << " µs" << std::endl;
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef FORWARDER_H
+#define FORWARDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "seal/seal.h"
+
+#include "aggregator.h"
+#include "config.h"
+#include "forwarder_stats.h"
+#include "he_context.h"
+#include "packet_assembler.h"
+#include "packet_io.h"
+#include "steering.h"
+#include "stream_patcher.h"
+#include "tenant_scheduler.h"
+
+// Porte e code servite da un lcore/thread
+struct ForwardingQueues {
+    struct {
+        uint16_t port_id = 0;
+        uint16_t queue_id = 0;
+    } ingress, egress;
+};
+
+// Datapath del forwarder: riassemblaggio dei frammenti -> operazione omomorfica -> frammentazione
+// e invio del risultato. Una istanza per lcore/thread, indipendente dal backend di I/O: tutto lo stato
+// (assembler, contesto SEAL, buffer) è privato dell'istanza, per evitare race condition
+class Forwarder {
+public:
+    // Destino di un pacchetto ricevuto: Consume, Forward o Drop (config.h)
+    using Verdict = TrafficVerdict;
+
+    // Verdetti per classe di traffico: telemetry e other da runtime_config() (verdict-telemetry,
+    // verdict-other), modificabili con set_verdict_policy
+    struct VerdictPolicy {
+        // Frammenti di telemetria. Forward li elabora e inoltra anche l'originale (raddoppia il traffico in uscita)
+        Verdict telemetry = Verdict::Consume;
+        // Tutto il resto (ARP, traffico di fondo, ...). Consume equivale a Drop
+        Verdict other = Verdict::Forward;
+        // Frammenti dei messaggi rifiutati dall'admission control (runtime_config().admission_forward).
+        // Con lo steering i frammenti arrivati da altri lcore sono copie e vengono sempre scartati
+        Verdict rejected = Verdict::Drop;
+    };
+
+    // agg_table != nullptr attiva l'aggregazione in-network, steering != nullptr lo steering per message_id
+    // (worker_id deve allora essere compreso tra 0 e steering->get_n_workers() - 1).
+    // Va costruito nel thread che lo userà (il pool di memoria SEAL dell'HEContext appartiene a quel thread)
+    Forwarder(PacketIO &io, AggregationTable *agg_table, MessageSteering *steering, int worker_id);
+    ~Forwarder();
+
+    // Riceve un burst da in_port/in_queue, elabora i frammenti di telemetria e inoltra su out_port/out_queue.
+    // Ritorna il numero di pacchetti ricevuti
+    uint16_t poll(uint16_t in_port, uint16_t in_queue, uint16_t out_port, uint16_t out_queue, uint16_t burst_size);
+
+    // Invia le finestre di aggregazione scadute e, in cut-through, scarta i messaggi incompleti scaduti
+    // (da chiamare anche quando non arriva traffico)
+    void poll_timers(uint16_t out_port, uint16_t out_queue);
+
+    // A fine esecuzione: invia le somme parziali di questo lcore e, se è l'ultimo a chiudere, tutte le
+    // finestre ancora aperte. Va chiamato dopo l'ultimo poll
+    void flush_aggregates(uint16_t out_port, uint16_t out_queue);
+
+    // Riassembla i frammenti inoltrati a questo lcore dagli altri (steering per message_id).
+    // Le risposte escono dalla coda del lcore sulla porta indicata nel frammento. Ritorna i frammenti presi
+    uint16_t poll_steered(const ForwardingQueues &queues, uint16_t burst_size);
+
+    // Elabora fino a tenant_he_budget messaggi dalle code dei tenant (runtime_config().tenant_scheduling).
+    // Ritorna i messaggi elaborati
+    uint32_t poll_scheduler();
+
+    // Aggiorna nelle statistiche la profondità della coda RX (costa una lettura dei descrittori:
+    // va fatto ogni tanto, non a ogni poll)
+    void sample_rx_queue_depth(uint16_t port, uint16_t queue);
+
+    HEContext &he() { return *he_ctx; }
+
+    void set_verdict_policy(const VerdictPolicy &p) { policy = p; }
+
+private:
+    // Classifica un pacchetto ricevuto, passa all'assembler i frammenti di telemetria e ritorna il verdetto.
+    // In cut-through il frammento viene corretto sul posto e inoltrato al receiver
+    Verdict process_packet(const Packet &pkt, uint16_t out_port, uint16_t out_queue);
+    // Passa un frammento (TelemetryHeader + chunk) all'assembler e, se il messaggio è completo, lo elabora
+    // (o lo accoda al suo tenant).
+    // Ritorna false se il messaggio è stato rifiutato dall'admission control
+    bool handle_fragment(const char *payload, uint16_t len, const FlowRoute &route,
+                         uint16_t out_port, uint16_t out_queue);
+    // Cut-through: passa un frammento a patcher. in_place = il frammento è nel pacchetto ricevuto e il
+    // chiamante lo inoltra (Forward); altrimenti (copie dallo steering) viene inviato in un nuovo pacchetto.
+    // I frammenti trattenuti diventati inoltrabili vengono inviati subito
+    Verdict stream_fragment(char *payload, uint16_t len, const FlowRoute &route,
+                            uint16_t out_port, uint16_t out_queue, bool in_place);
+    // Admission control: un messaggio viene accettato o rifiutato al primo frammento, in base a rx_depth
+    bool admit(const char *payload, uint16_t len);
+    // Elabora un messaggio riassemblato (route: indirizzi del pacchetto che lo ha completato)
+    void process_message(const PacketAssembler::AssemblyResult &result, const FlowRoute &route,
+                         uint16_t out_port, uint16_t out_queue);
+    // Frammenta il payload (slot-map + ciphertext) e lo invia sulla porta di uscita
+    void send_fragments(uint16_t out_port, uint16_t out_queue, const FlowRoute &route,
+                        uint32_t message_id, const std::vector<seal::seal_byte> &payload);
+    // Invia frammenti già pronti (header di telemetria + chunk)
+    void send_raw_fragments(uint16_t out_port, uint16_t out_queue, const FlowRoute &route,
+                            const std::vector<std::vector<char>> &fragments);
+    // Scrive gli header Ethernet/IPv4/UDP (verso rx_port) e ritorna dove inizia il payload UDP
+    uint8_t *write_frame_headers(uint8_t *pkt_data, const FlowRoute &route, uint16_t payload_size);
+    // Invia i primi n pacchetti di tx_pkts e aggiorna le statistiche
+    void transmit(uint16_t out_port, uint16_t out_queue, uint32_t n);
+    // Invia le finestre di aggregazione chiuse
+    void send_aggregated(uint16_t out_port, uint16_t out_queue);
+
+    PacketIO &io;
+    int worker_id;
+    PacketAssembler assembler;
+    HEContext *he_ctx;
+    LcoreAggregator *lcore_agg = nullptr;
+    StreamPatcher *patcher = nullptr;                // Cut-through (runtime_config().cut_through)
+    std::chrono::milliseconds stream_timeout{0};     // runtime_config().stream_timeout_ms
+    bool streamed_in_place = false;                  // L'ultimo pacchetto di process_packet è stato corretto in cut-through
+    TenantScheduler *scheduler = nullptr;            // Code per tenant (runtime_config().tenant_scheduling)
+    PendingMessage pending;                          // Messaggio da/per le code dei tenant
+    uint32_t he_budget = 0;
+    MessageSteering *steering;
+    LcoreStats *stats;                               // lcore_stats(worker_id)
+    SteeredFragment steered;                         // Frammento da/per un altro lcore (troppo grande per lo stack)
+    std::vector<seal::seal_byte> ciphertext_buffer;  // Buffer riutilizzabile per evitare allocazioni
+    std::vector<AggregateResult> aggregated;         // Finestre chiuse da inviare
+    uint32_t agg_sent = 0;                           // Aggregati inviati (vedi aggregate_message_id)
+    std::vector<Packet> tx_pkts;                     // Frammenti della risposta
+    VerdictPolicy policy;
+    uint16_t base_port, n_ports, rx_port;            // Da runtime_config()
+    uint64_t lower_bound;
+    size_t slot_sum_group;                           // 0 = nessuna riduzione degli slot
+    uint32_t admission_watermark;                    // 0 = admission control disattivato
+    uint32_t rx_depth = 0;                           // Profondità della coda letta nel poll corrente
+    std::vector<uint64_t> rejected;                  // message_id + 1 rifiutati (0 = slot vuoto), per message_id % slot
+    Packet rx_pkts[PACKET_IO_MAX_BURST];
+    Packet free_pkts[PACKET_IO_MAX_BURST];           // Pacchetti da liberare a fine burst
+    bool fwd_streamed[PACKET_IO_MAX_BURST];          // Per i pacchetti da inoltrare: corretti in cut-through
+};
+
+// Ciclo di polling di un lcore/thread: ingress -> egress e viceversa finché exit_request è false.
+// burst_size è il burst massimo: con adaptive_burst (runtime_config()) il burst di ogni direzione
+// scende fino a burst_min quando arriva poco traffico e risale quando i burst tornano pieni.
+// Ogni giro fa poll_weight_ingress poll dell'ingress e poll_weight_egress dell'egress (si smette prima
+// se la coda è vuota). Dopo idle_spin_polls giri a vuoto, con idle_backoff, il ciclo cede la CPU
+// (pause, poi sleep crescenti fino a idle_sleep_us se > 0) finché non arriva di nuovo qualcosa.
+// Ogni STATS_SAMPLE_ROUNDS giri campiona la profondità della coda RX dell'ingress
+void run_forwarding_loop(Forwarder &fwd, const ForwardingQueues &queues, uint16_t burst_size,
+                         const std::atomic_bool &exit_request);
+
+// Contatori atomici per benchmark HE (condivisi da tutti i lcore)
+extern std::atomic<long> total_load_us;
+extern std::atomic<long> total_add_us;
+extern std::atomic<long> total_save_us;
+extern std::atomic<long> he_op_count;
+
+// Stampa le medie dei tempi delle operazioni HE
+void print_he_benchmark();
+
+// Checksum dell'header IPv4 (complemento a uno della somma a 16 bit), come rte_ipv4_cksum
+struct iphdr;
+uint16_t ipv4_checksum(const struct iphdr *ip);
+
+#endif
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "forwarder_stats.h"
+
+const char *const STAT_NAMES[N_STATS] = {
+    "rx_pkts",
+    "rx_bytes",
+    "tx_pkts",
+    "tx_bytes",
+    "fwd_pkts",
+    "drop_policy",
+    "drop_tx_full",
+    "drop_alloc",
+    "drop_steer_full",
+    "drop_bad_message",
+    "drop_admission",
+    "rejected_messages",
+    "completed_messages",
+    "he_ops",
+    "streamed_frags",
+    "drop_stream",
+    "stream_expired",
+    "drop_tenant_queue",
+    "drop_tenant_rate",
+    "reassembly_in_flight",
+    "rx_queue_depth",
+    "tenant_backlog",
+};
+
+static LcoreStats stats[STATS_MAX_LCORES];
+static std::atomic<unsigned> n_lcores{0};
+
+LcoreStats &lcore_stats(unsigned worker_id)
+{
+    // I main rifiutano all'avvio più di STATS_MAX_LCORES thread/code
+    assert(worker_id < STATS_MAX_LCORES);
+    return stats[worker_id];
+}
+
+void set_stats_lcore_count(unsigned n)
+{
+    n_lcores.store(std::min(n, STATS_MAX_LCORES));
+}
+
+unsigned stats_lcore_count()
+{
+    return n_lcores.load();
+}
+
+StatsSnapshot read_lcore_stats(unsigned worker_id)
+{
+    StatsSnapshot snap;
+    for (unsigned s = 0; s < N_STATS; s++)
+        snap[s] = stats[worker_id].counters[s].load(std::memory_order_relaxed);
+    return snap;
+}
+
+StatsSnapshot read_total_stats()
+{
+    StatsSnapshot total{};
+    for (unsigned w = 0; w < stats_lcore_count(); w++) {
+        StatsSnapshot snap = read_lcore_stats(w);
+        for (unsigned s = 0; s < N_STATS; s++)
+            total[s] += snap[s];
+    }
+    return total;
+}
+
+static uint64_t total_drops(const StatsSnapshot &snap)
+{
+    return snap[STAT_DROP_POLICY] + snap[STAT_DROP_TX_FULL] + snap[STAT_DROP_ALLOC] +
+           snap[STAT_DROP_STEER_FULL] + snap[STAT_DROP_BAD_MESSAGE] + snap[STAT_DROP_ADMISSION] +
+           snap[STAT_DROP_TENANT_QUEUE] + snap[STAT_DROP_TENANT_RATE];
+}
+
+// Riga con i ratei tra due fotografie e i gauge dell'ultima
+static void print_stats_line(const StatsSnapshot &prev, const StatsSnapshot &cur, double seconds)
+{
+    auto rate = [&](Stat s) { return (cur[s] - prev[s]) / seconds; };
+
+    // Profondità massima tra le code RX, per vedere un lcore che non tiene il passo
+    uint64_t max_depth = 0;
+    for (unsigned w = 0; w < stats_lcore_count(); w++)
+        max_depth = std::max<uint64_t>(max_depth, lcore_stats(w).counters[STAT_RX_QUEUE_DEPTH].load(std::memory_order_relaxed));
+
+    printf("[STATS] rx %.0f pps %.1f Mbps | tx %.0f pps %.1f Mbps | drop %.0f/s | msg %.0f/s | he %.0f/s | in volo %lu | coda max %lu\n",
+           rate(STAT_RX_PKTS), rate(STAT_RX_BYTES) * 8 / 1e6,
+           rate(STAT_TX_PKTS), rate(STAT_TX_BYTES) * 8 / 1e6,
+           (total_drops(cur) - total_drops(prev)) / seconds,
+           rate(STAT_COMPLETED_MESSAGES), rate(STAT_HE_OPS),
+           (unsigned long)cur[STAT_REASSEMBLY_IN_FLIGHT], (unsigned long)max_depth);
+    fflush(stdout);
+}
+
+std::thread start_stats_reporter(unsigned interval_ms, const std::atomic_bool &exit_request)
+{
+    return std::thread([interval_ms, &exit_request]() {
+        StatsSnapshot prev = read_total_stats();
+        auto prev_time = std::chrono::steady_clock::now();
+        while (!exit_request.load()) {
+            // Sleep a passi brevi per terminare subito dopo CTRL+C
+            auto deadline = prev_time + std::chrono::milliseconds(interval_ms);
+            while (!exit_request.load() && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::min(interval_ms, 100u)));
+            if (exit_request.load())
+                break;
+
+            StatsSnapshot cur = read_total_stats();
+            auto now = std::chrono::steady_clock::now();
+            print_stats_line(prev, cur, std::chrono::duration<double>(now - prev_time).count());
+            prev = cur;
+            prev_time = now;
+        }
+    });
+}
+
+void print_stats_summary()
+{
+    StatsSnapshot total = read_total_stats();
+    std::cout << "Statistiche del datapath (" << stats_lcore_count() << " lcore):" << std::endl;
+    for (unsigned s = 0; s < N_STATS; s++) {
+        if (s == STAT_REASSEMBLY_IN_FLIGHT || s == STAT_RX_QUEUE_DEPTH || s == STAT_TENANT_BACKLOG)
+            continue;  // Gauge: a fine esecuzione non dicono niente
+        std::cout << "  " << STAT_NAMES[s] << ": " << total[s] << std::endl;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FORWARDER_STATS_H
+#define FORWARDER_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Numero massimo di lcore/thread con statistiche (come RTE_MAX_LCORE di default)
+constexpr unsigned STATS_MAX_LCORES = 128;
+
+// Contatori del datapath. I gauge (in volo, profondità della coda) contengono l'ultimo valore campionato
+enum Stat : unsigned {
+    STAT_RX_PKTS,
+    STAT_RX_BYTES,
+    STAT_TX_PKTS,                // Risposte e pacchetti inoltrati
+    STAT_TX_BYTES,
+    STAT_FWD_PKTS,               // Inoltrati invariati (verdetto Forward, esclusi quelli corretti in cut-through)
+    STAT_DROP_POLICY,            // Verdetto Drop della policy
+    STAT_DROP_TX_FULL,           // Coda TX piena
+    STAT_DROP_ALLOC,             // Risposta non inviata per buffer esauriti
+    STAT_DROP_STEER_FULL,        // Coda di steering del proprietario piena
+    STAT_DROP_BAD_MESSAGE,       // Messaggio riassemblato non valido (slot-map)
+    STAT_DROP_ADMISSION,         // Frammenti di messaggi rifiutati dall'admission control (non inoltrati)
+    STAT_REJECTED_MESSAGES,      // Messaggi rifiutati dall'admission control
+    STAT_COMPLETED_MESSAGES,     // Messaggi riassemblati
+    STAT_HE_OPS,                 // Operazioni omomorfiche (anche sotto lower_bound)
+    STAT_STREAMED_FRAGS,         // Frammenti corretti e inoltrati in cut-through
+    STAT_DROP_STREAM,            // Frammenti scartati dal cut-through (duplicati, incoerenti, messaggio non valido)
+    STAT_STREAM_EXPIRED,         // Messaggi incompleti scartati dal cut-through dopo stream-timeout-ms
+    STAT_DROP_TENANT_QUEUE,      // Messaggi scartati con la coda del loro tenant piena
+    STAT_DROP_TENANT_RATE,       // Messaggi scartati oltre il rate limit del tenant
+    STAT_REASSEMBLY_IN_FLIGHT,   // Gauge: messaggi incompleti nell'assembler (o in cut-through)
+    STAT_RX_QUEUE_DEPTH,         // Gauge: descrittori pieni nella coda RX dell'ingress
+    STAT_TENANT_BACKLOG,         // Gauge: messaggi nelle code dei tenant
+    N_STATS
+};
+
+// Nomi usati nella telemetria e nella riga periodica
+extern const char *const STAT_NAMES[N_STATS];
+
+// Una fotografia dei contatori (di un lcore o sommati su tutti)
+using StatsSnapshot = std::array<uint64_t, N_STATS>;
+
+// Statistiche di un lcore: scritte solo dal suo thread (senza istruzioni atomiche read-modify-write),
+// lette dagli altri. Allineate alla cache line per non condividerla tra lcore (false sharing)
+struct alignas(64) LcoreStats {
+    std::atomic<uint64_t> counters[N_STATS] = {};
+
+    void add(Stat s, uint64_t n)
+    {
+        counters[s].store(counters[s].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set(Stat s, uint64_t v) { counters[s].store(v, std::memory_order_relaxed); }
+
+    uint64_t get(Stat s) const { return counters[s].load(std::memory_order_relaxed); }
+};
+
+// Statistiche del lcore worker_id (0 <= worker_id < STATS_MAX_LCORES, da verificare all'avvio)
+LcoreStats &lcore_stats(unsigned worker_id);
+
+// Numero di lcore attivi: va impostato all'avvio, prima di lanciare i worker
+void set_stats_lcore_count(unsigned n);
+unsigned stats_lcore_count();
+
+StatsSnapshot read_lcore_stats(unsigned worker_id);
+StatsSnapshot read_total_stats();
+
+// Thread che stampa ogni interval_ms una riga con pps, byte/s, scarti e messaggi completati di tutti
+// i lcore (runtime_config().stats_interval_ms). Termina quando exit_request diventa true
+std::thread start_stats_reporter(unsigned interval_ms, const std::atomic_bool &exit_request);
+
+// Stampa i totali (a fine esecuzione)
+void print_stats_summary();
+
+#endif
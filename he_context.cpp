@@ -0,0 +1,173 @@
+#include <algorithm>
+
+#include "he_context.h"
+#include "param_set.h"
+
+using namespace seal;
+
+// Somma modulare elemento per elemento (a, b < q). Il ciclo non ha dipendenze tra iterazioni e
+// la riduzione è un'unica sottrazione condizionale: con -O3 -march=native il compilatore lo
+// vettorizza con AVX2/AVX-512 quando disponibili
+static inline void add_mod_vector(uint64_t* __restrict a, const uint64_t* __restrict b, size_t n, uint64_t q) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t s = a[i] + b[i];  // I moduli di SEAL hanno al massimo 61 bit: nessun overflow
+        a[i] = s - (s >= q ? q : 0);
+    }
+}
+
+// Versione con numero di coefficienti noto a compile time per i gradi più comuni: il ciclo ha un
+// numero fisso di iterazioni e viene srotolato/vettorizzato senza il codice per il resto
+template <size_t N>
+static inline void add_mod_vector_fixed(uint64_t* __restrict a, const uint64_t* __restrict b, uint64_t q) {
+    add_mod_vector(a, b, N, q);
+}
+
+// Somma del plaintext scalato a c0 per tutti i moduli RNS. Per gli insiemi di parametri di param_set.h
+// grado e numero di moduli sono costanti: l'istanza giusta viene scelta una volta sola in prepare_scaled_plain
+template <class P>
+static void add_scaled_poly_fixed(uint64_t* c0, const uint64_t* scaled, const uint64_t* moduli, size_t, size_t) {
+    for (size_t j = 0; j < P::ct_moduli; j++)
+        add_mod_vector_fixed<P::degree>(c0 + j * P::degree, scaled + j * P::degree, moduli[j]);
+}
+
+static void add_scaled_poly(uint64_t* c0, const uint64_t* scaled, const uint64_t* moduli, size_t n, size_t k) {
+    for (size_t j = 0; j < k; j++)
+        add_mod_vector(c0 + j * n, scaled + j * n, n, moduli[j]);
+}
+
+HEContext::HEContext(std::shared_ptr<const SEALContext> context)
+    : pool(MemoryPoolHandle::New()), context(std::move(context)), ptx_buffer(pool), ct_buffer(pool), rot_buffer(pool) {
+    evaluator = new Evaluator(*this->context);
+    encoder = new BatchEncoder(*this->context);
+    
+    values_buffer.resize(encoder->slot_count());
+}
+
+HEContext::~HEContext() {
+    delete encoder;
+    delete evaluator;
+}
+
+const RelinKeys* HEContext::relin_keys() {
+    if (!relin_requested) {
+        relin = ::relin_keys();
+        relin_requested = true;
+    }
+    return relin.get();
+}
+
+const GaloisKeys* HEContext::galois_keys() {
+    if (!galois_requested) {
+        galois = ::galois_keys();
+        galois_requested = true;
+    }
+    return galois.get();
+}
+
+bool HEContext::can_sum_slots(size_t group) {
+    const GaloisKeys* keys = galois_keys();
+    size_t slot_count = encoder->slot_count();
+    if (!keys || group < 2 || group > slot_count || (group & (group - 1)) != 0)
+        return false;
+
+    // Con il batching gli slot sono due righe di slot_count/2: rotate_rows ruota dentro ogni riga,
+    // rotate_columns (passo 0) scambia le due righe
+    const auto* galois_tool = context->key_context_data()->galois_tool();
+    size_t row_size = slot_count / 2;
+    for (size_t step = 1; step < std::min(group, row_size); step <<= 1) {
+        if (!keys->has_key(galois_tool->get_elt_from_step((int)step)))
+            return false;
+    }
+    return group <= row_size || keys->has_key(galois_tool->get_elt_from_step(0));
+}
+
+void HEContext::sum_slots(Ciphertext& ct, size_t group) {
+    // Dopo la somma con la rotazione di step lo slot i contiene gli slot i..i+2*step-1
+    const GaloisKeys& keys = *galois;
+    size_t row_size = encoder->slot_count() / 2;
+    for (size_t step = 1; step < std::min(group, row_size); step <<= 1) {
+        evaluator->rotate_rows(ct, (int)step, keys, rot_buffer, pool);
+        evaluator->add_inplace(ct, rot_buffer);
+    }
+    if (group > row_size) {
+        evaluator->rotate_columns(ct, keys, rot_buffer, pool);
+        evaluator->add_inplace(ct, rot_buffer);
+    }
+}
+
+void HEContext::add_plain_number(Ciphertext& ct, uint64_t number) {
+    std::fill(values_buffer.begin(), values_buffer.end(), number);
+    encoder->encode(values_buffer, ptx_buffer);
+    evaluator->add_plain_inplace(ct, ptx_buffer, pool);
+}
+
+void HEContext::add_plain_number_fast(Ciphertext& ct, uint64_t number) {
+    // BFV lavora in forma coefficienti: in forma NTT (o con un ciphertext non valido) si usa il percorso generico
+    if (ct.is_ntt_form() || ct.size() < 2) {
+        add_plain_number(ct, number);
+        return;
+    }
+
+    if (!scaled_plain.valid || scaled_plain.number != number || scaled_plain.parms_id != ct.parms_id()) {
+        // Il primo ciphertext viene elaborato dal percorso generico durante la preparazione
+        prepare_scaled_plain(ct, number);
+        add_plain_number(ct, number);
+        return;
+    }
+
+    const size_t n = scaled_plain.poly_degree;
+    uint64_t* c0 = ct.data(0);
+
+    if (scaled_plain.constant_only) {
+        for (size_t j = 0; j < scaled_plain.moduli.size(); j++) {
+            uint64_t q = scaled_plain.moduli[j];
+            uint64_t s = c0[j * n] + scaled_plain.scaled[j * n];
+            c0[j * n] = s - (s >= q ? q : 0);
+        }
+    } else {
+        scaled_plain.add(c0, scaled_plain.scaled.data(), scaled_plain.moduli.data(), n, scaled_plain.moduli.size());
+    }
+}
+
+void HEContext::prepare_scaled_plain(const Ciphertext& sample, uint64_t number) {
+    auto context_data = context->get_context_data(sample.parms_id());
+    const auto& coeff_modulus = context_data->parms().coeff_modulus();
+    const size_t n = sample.poly_modulus_degree();
+    const size_t k = sample.coeff_modulus_size();
+
+    Ciphertext tmp(pool);
+    tmp = sample;
+    add_plain_number(tmp, number);
+
+    scaled_plain.number = number;
+    scaled_plain.parms_id = sample.parms_id();
+    scaled_plain.poly_degree = n;
+    scaled_plain.moduli.resize(k);
+    scaled_plain.scaled.resize(k * n);
+    scaled_plain.constant_only = true;
+    scaled_plain.add = dispatch_param_set(n, [k](auto params) -> ScaledPlain::AddFn {
+        using P = decltype(params);
+        if constexpr (P::fixed) {
+            if (k == P::ct_moduli)
+                return &add_scaled_poly_fixed<P>;
+        }
+        return &add_scaled_poly;
+    });
+
+    const uint64_t* before = sample.data(0);
+    const uint64_t* after = tmp.data(0);
+    for (size_t j = 0; j < k; j++) {
+        uint64_t q = coeff_modulus[j].value();
+        scaled_plain.moduli[j] = q;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t d = after[j * n + i] >= before[j * n + i]
+                             ? after[j * n + i] - before[j * n + i]
+                             : after[j * n + i] + q - before[j * n + i];
+            scaled_plain.scaled[j * n + i] = d;
+            if (i > 0 && d != 0)
+                scaled_plain.constant_only = false;
+        }
+    }
+
+    scaled_plain.valid = true;
+}
@@ -0,0 +1,89 @@
+#ifndef HE_CONTEXT_H
+#define HE_CONTEXT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "seal/seal.h"
+
+#include "seal_params.h"
+
+// Classe per gestire operazioni omomorifiche
+class HEContext {
+public:
+    // Pool di memoria privato dell'istanza (una per lcore): le allocazioni del percorso caldo non
+    // passano dal pool globale di SEAL condiviso da tutti i thread. Deve precedere i membri che lo usano.
+    // Non è MemoryPoolHandle::ThreadLocal() perché i ciphertext aggregati possono essere liberati
+    // da un altro lcore (AggregationTable), e il pool thread-local non è thread-safe
+    seal::MemoryPoolHandle pool;
+
+    // Contesto condiviso da tutti gli lcore (vedi seal_context()): per lcore restano solo evaluator,
+    // encoder, pool e buffer
+    std::shared_ptr<const seal::SEALContext> context;
+
+    //Uso puntatori per facilitare l'inizializzazione nel costruttore
+    seal::Evaluator* evaluator;
+    seal::BatchEncoder* encoder;
+    
+    // Buffer pre-allocati per evitare allocazioni ripetute in add_plain_number
+    std::vector<uint64_t> values_buffer;
+    seal::Plaintext ptx_buffer;
+
+    // Ciphertext riutilizzato per ogni messaggio (ricaricato con load invece di crearne uno nuovo)
+    seal::Ciphertext ct_buffer;
+    
+    explicit HEContext(std::shared_ptr<const seal::SEALContext> context = seal_context());
+    ~HEContext();
+    
+    // Somma un numero in chiaro al ciphertext (percorso generico: encode + add_plain_inplace)
+    void add_plain_number(seal::Ciphertext& ct, uint64_t number);
+
+    // Stesso risultato di add_plain_number, ma la costante scalata per Delta e scomposta in RNS
+    // viene calcolata una volta sola: ogni chiamata si riduce a somme modulari sul primo polinomio
+    void add_plain_number_fast(seal::Ciphertext& ct, uint64_t number);
+
+    // Chiavi di valutazione condivise da tutti gli lcore (vedi relin_keys() e galois_keys() in
+    // seal_params.h): caricate alla prima richiesta, poi lette senza lock. nullptr se mancano
+    const seal::RelinKeys* relin_keys();
+    const seal::GaloisKeys* galois_keys();
+
+    // Somma degli slot a gruppi di group slot consecutivi (potenza di 2, al massimo slot_count): il
+    // primo slot di ogni gruppo allineato riceve la somma del gruppo, con group = slot_count tutti gli
+    // slot contengono la somma totale. log2(group) rotazioni e somme, con un solo ciphertext intermedio
+    // riusato. Va chiamata solo se can_sum_slots(group)
+    void sum_slots(seal::Ciphertext& ct, size_t group);
+
+    // Vero se ci sono le Galois key di tutte le rotazioni usate da sum_slots(group)
+    bool can_sum_slots(size_t group);
+
+private:
+    // Risultato delle rotazioni di sum_slots, allocato nel pool del lcore e riusato
+    seal::Ciphertext rot_buffer;
+
+    std::shared_ptr<const seal::RelinKeys> relin;
+    std::shared_ptr<const seal::GaloisKeys> galois;
+    bool relin_requested = false;
+    bool galois_requested = false;
+
+    // Plaintext già scalato e in forma RNS, pronto per essere sommato a c0
+    struct ScaledPlain {
+        bool valid = false;
+        uint64_t number = 0;
+        seal::parms_id_type parms_id;
+        size_t poly_degree = 0;
+        // Una costante codificata con BatchEncoder è un polinomio di grado 0: basta sommare
+        // il coefficiente 0 di ogni componente RNS invece di tutti i poly_degree coefficienti
+        bool constant_only = false;
+        std::vector<uint64_t> moduli;   // Valori q_j dei moduli RNS
+        std::vector<uint64_t> scaled;   // Componenti RNS (moduli.size() * poly_degree valori)
+        // Somma a c0, specializzata sui parametri (param_set.h) quando grado e numero di moduli sono noti
+        using AddFn = void (*)(uint64_t* c0, const uint64_t* scaled, const uint64_t* moduli, size_t n, size_t k);
+        AddFn add = nullptr;
+    } scaled_plain;
+
+    // Ricava la costante scalata da un ciphertext di esempio: add_plain_inplace somma a c0 sempre lo
+    // stesso polinomio, per cui basta la differenza tra c0 prima e dopo il percorso generico
+    void prepare_scaled_plain(const seal::Ciphertext& sample, uint64_t number);
+};
+
+#endif
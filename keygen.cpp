@@ -1,22 +1,98 @@
 // Genera chiavi SEAL e le salva su file, da eseguire prima di receiver e sender
+//
+//   keygen [--relin] [--galois all|<passo>,<passo>,...]
+//       --relin: anche le relinearization key (relin.key), per le moltiplicazioni tra ciphertext
+//       --galois: anche le Galois key (galois.key) per le rotazioni degli slot di quei passi
+//       (rotate_rows, 0 = rotate_columns), "all" = tutte le potenze di 2 più le colonne.
+//       Sono salvate seeded (metà della dimensione) e compresse. Richiedono poly-modulus-degree >= 4096
+//       (con 2048 c'è un solo coeff modulus e manca lo special prime)
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "seal/seal.h"
-#include "config.h"
+#include "runtime_config.h"
+#include "seal_params.h"
 
 using namespace seal;
 using namespace std;
 
+// Passi di rotazione separati da virgole. Ritorna false se un passo non è un intero
+static bool parse_steps(const string &list, vector<int> &steps) {
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ',')) {
+        char *end;
+        long step = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0')
+            return false;
+        steps.push_back((int)step);
+    }
+    return !steps.empty();
+}
 
-int main() {
-    // Parametri da config.h
-    EncryptionParameters parms(scheme_type::bfv);
-    parms.set_poly_modulus_degree(POLY_MODULUS_DEGREE);
-    parms.set_coeff_modulus(CoeffModulus::BFVDefault(POLY_MODULUS_DEGREE));
-    parms.set_plain_modulus(PLAIN_MODULUS);
-    
+// Salva una chiave seeded: la parte pseudo-casuale viene rigenerata dal seed al caricamento
+template <class T>
+static bool save_serializable(const Serializable<T> &keys, const char *path) {
+    ofstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Impossibile creare " << path << endl;
+        return false;
+    }
+    streamoff size = keys.save(file);
+    cout << "Salvata " << path << " (" << size << " bytes)" << endl;
+    return (bool)file;
+}
+
+int main(int argc, char* argv[]) {
+    // Parametri da config.h, modificabili con --config <file> o --poly-modulus-degree/--plain-modulus
+    RuntimeConfig& cfg = runtime_config();
+    if (!parse_config_args(cfg, argc, argv))
+        return 1;
+
+    bool relin = false;
+    bool galois_all = false;
+    vector<int> galois_steps;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--relin") == 0) {
+            relin = true;
+        } else if (strcmp(argv[i], "--galois") == 0 && i + 1 < argc) {
+            string list = argv[++i];
+            if (list == "all") {
+                galois_all = true;
+            } else if (!parse_steps(list, galois_steps)) {
+                cerr << "Passi di rotazione non validi: " << list << endl;
+                return 1;
+            }
+            // Entrambe scriverebbero galois.key, e la seconda sovrascriverebbe la prima
+            if (galois_all && !galois_steps.empty()) {
+                cerr << "--galois all e --galois <passi> non possono essere usati insieme" << endl;
+                return 1;
+            }
+        } else {
+            cerr << "Argomenti non validi: [--relin] [--galois all|<passo>,<passo>,...]" << endl;
+            return 1;
+        }
+    }
+
+    EncryptionParameters parms = make_encryption_parameters(cfg);
     SEALContext context(parms);
+
+    // Le chiavi di valutazione richiedono lo special prime, che c'è solo con più di un coeff modulus:
+    // si controlla prima di scrivere qualsiasi file
+    if ((relin || galois_all || !galois_steps.empty()) && !context.using_keyswitching()) {
+        cerr << "Relinearization e Galois key non disponibili con grado " << cfg.poly_modulus_degree
+             << " (un solo coeff modulus): serve poly-modulus-degree >= 4096" << endl;
+        return 1;
+    }
+
+    // Salva i parametri: gli altri programmi li caricano da qui invece che dalla propria configurazione
+    if (!save_encryption_parameters(parms))
+        return 1;
+    cout << "Salvato " << PARMS_FILE << endl;
     
     // Genera le chiavi
     KeyGenerator keygen(context);
@@ -35,6 +111,14 @@ int main() {
     public_key.save(pk_file);
     pk_file.close();
     cout << "Salvata public.key" << endl;
+
+    // Chiavi di valutazione (opzionali, il forwarder le carica solo se le usa)
+    if (relin && !save_serializable(keygen.create_relin_keys(), RELIN_KEYS_FILE))
+        return 1;
+    if (galois_all && !save_serializable(keygen.create_galois_keys(), GALOIS_KEYS_FILE))
+        return 1;
+    if (!galois_steps.empty() && !save_serializable(keygen.create_galois_keys(galois_steps), GALOIS_KEYS_FILE))
+        return 1;
         
     return 0;
 }
@@ -10,7 +10,7 @@ Message::Message(const std::string& data, uint32_t msg_id)
     : data(data), message_id(msg_id), sock(-1), socket_created(false) {
     memset(&dest_addr, 0, sizeof(dest_addr));
     // Buffer pre allocato per l'invio
-    send_buffer.reserve(sizeof(TelemetryHeader) + CHUNK_SIZE);
+    send_buffer.reserve(sizeof(TelemetryHeader) + sizeof(TelemetryHeaderWide) + CHUNK_SIZE);
 }
 
 // Distruttore
@@ -74,19 +74,11 @@ int32_t Message::send() {
         uint32_t remaining = total_size - offset;
         uint32_t chunk_size = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
         
-        // Creazione header
-        TelemetryHeader hdr;
-        hdr.message_id = message_id;
-        hdr.total_chunks = static_cast<uint16_t>(num_chunks);
-        hdr.chunk_index = static_cast<uint16_t>(i);
-        hdr.ciphertext_total_size = total_size;
-        hdr.chunk_size = static_cast<uint16_t>(chunk_size);
-        
-        // Preparo buffer (ridimensiona solo se serve)
-        send_buffer.resize(sizeof(TelemetryHeader) + chunk_size);
-        
-        memcpy(send_buffer.data(), &hdr, sizeof(TelemetryHeader));
-        memcpy(send_buffer.data() + sizeof(TelemetryHeader), data.data() + offset, chunk_size);
+        // Preparo buffer (ridimensiona solo se serve) e header (esteso oltre 65535 chunk)
+        size_t hdr_size = fragment_header_size(num_chunks);
+        send_buffer.resize(hdr_size + chunk_size);
+        write_fragment_header(send_buffer.data(), message_id, num_chunks, i, total_size, static_cast<uint16_t>(chunk_size));
+        memcpy(send_buffer.data() + hdr_size, data.data() + offset, chunk_size);
         
         // Invio
         int32_t sent = sendto(sock, send_buffer.data(), send_buffer.size(), 0,
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <netinet/in.h>
 
 const uint16_t CHUNK_SIZE = 1000; //Non conta l'header
@@ -17,8 +18,109 @@ struct TelemetryHeader {
     uint32_t ciphertext_total_size; 
     uint16_t chunk_size;            
 };                                  // Totale di 14 bytes
+
+// Messaggi con più di 65535 frammenti (gradi alti, più ciphertext in un messaggio): total_chunks = 0
+// nell'header indica che dopo TelemetryHeader seguono total_chunks e chunk_index a 32 bit
+struct TelemetryHeaderWide {
+    uint32_t total_chunks;
+    uint32_t chunk_index;
+};                                  // 8 bytes dopo TelemetryHeader
 #pragma pack(pop)
 
+constexpr uint16_t TELEMETRY_WIDE = 0;
+
+// Campi di un frammento con header normale o esteso
+struct FragmentInfo {
+    uint32_t message_id;
+    uint32_t total_chunks;
+    uint32_t chunk_index;
+    uint32_t total_size;
+    uint16_t chunk_size;
+    uint16_t header_size;           // Byte di header prima del chunk
+};
+
+inline size_t fragment_header_size(uint32_t total_chunks) {
+    return sizeof(TelemetryHeader) + (total_chunks > UINT16_MAX ? sizeof(TelemetryHeaderWide) : 0);
+}
+
+// Legge l'header di un frammento. Ritorna false se il frammento è più corto di header + chunk_size
+// o se chunk_index non è minore di total_chunks
+inline bool parse_fragment_header(const char* packet, size_t size, FragmentInfo& info) {
+    if (size < sizeof(TelemetryHeader))
+        return false;
+    TelemetryHeader hdr;
+    memcpy(&hdr, packet, sizeof(TelemetryHeader));
+    info.message_id = hdr.message_id;
+    info.total_chunks = hdr.total_chunks;
+    info.chunk_index = hdr.chunk_index;
+    info.total_size = hdr.ciphertext_total_size;
+    info.chunk_size = hdr.chunk_size;
+    info.header_size = sizeof(TelemetryHeader);
+    if (hdr.total_chunks == TELEMETRY_WIDE) {
+        if (size < sizeof(TelemetryHeader) + sizeof(TelemetryHeaderWide))
+            return false;
+        TelemetryHeaderWide wide;
+        memcpy(&wide, packet + sizeof(TelemetryHeader), sizeof(TelemetryHeaderWide));
+        info.total_chunks = wide.total_chunks;
+        info.chunk_index = wide.chunk_index;
+        info.header_size += sizeof(TelemetryHeaderWide);
+    }
+    return info.chunk_index < info.total_chunks && info.chunk_size <= size - info.header_size;
+}
+
+// Scrive l'header del frammento (esteso solo se total_chunks non entra in 16 bit), ritorna i byte scritti
+inline size_t write_fragment_header(char* dst, uint32_t message_id, uint32_t total_chunks, uint32_t chunk_index,
+                                    uint32_t total_size, uint16_t chunk_size) {
+    TelemetryHeader hdr;
+    hdr.message_id = message_id;
+    hdr.ciphertext_total_size = total_size;
+    hdr.chunk_size = chunk_size;
+    if (total_chunks <= UINT16_MAX) {
+        hdr.total_chunks = (uint16_t)total_chunks;
+        hdr.chunk_index = (uint16_t)chunk_index;
+        memcpy(dst, &hdr, sizeof(TelemetryHeader));
+        return sizeof(TelemetryHeader);
+    }
+    hdr.total_chunks = TELEMETRY_WIDE;
+    hdr.chunk_index = 0;
+    TelemetryHeaderWide wide{total_chunks, chunk_index};
+    memcpy(dst, &hdr, sizeof(TelemetryHeader));
+    memcpy(dst + sizeof(TelemetryHeader), &wide, sizeof(TelemetryHeaderWide));
+    return sizeof(TelemetryHeader) + sizeof(TelemetryHeaderWide);
+}
+
+// Slot-map del batching: precede il ciphertext nel payload di ogni messaggio e dice a quale
+// sorgente appartiene ogni slot. Viaggia in chiaro e il forwarder la copia invariata in uscita.
+#pragma pack(push, 1)
+struct SlotMapHeader {
+    uint16_t n_entries;     // 0 = nessuna slot-map, tutti gli slot contengono lo stesso valore
+};
+struct SlotMapEntry {
+    uint16_t source_id;     // Sorgente dei campioni
+    uint16_t first_slot;    // Primo slot occupato dalla sorgente
+    uint16_t n_slots;       // Numero di slot consecutivi della sorgente
+};
+#pragma pack(pop)
+
+// Legge la slot-map all'inizio del payload (se entries != nullptr ne copia le voci).
+// Ritorna il numero di byte occupati dalla slot-map, 0 se il payload è malformato
+inline size_t parse_slot_map(const char* payload, size_t size, std::vector<SlotMapEntry>* entries = nullptr) {
+    if (size < sizeof(SlotMapHeader))
+        return 0;
+
+    SlotMapHeader hdr;
+    memcpy(&hdr, payload, sizeof(SlotMapHeader));
+    size_t map_size = sizeof(SlotMapHeader) + hdr.n_entries * sizeof(SlotMapEntry);
+    if (map_size > size)
+        return 0;
+
+    if (entries) {
+        entries->resize(hdr.n_entries);
+        memcpy(entries->data(), payload + sizeof(SlotMapHeader), hdr.n_entries * sizeof(SlotMapEntry));
+    }
+    return map_size;
+}
+
 class Message {
 private:
     std::string data;           // Dati del messaggio (ciphertext)
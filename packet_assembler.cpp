@@ -1,63 +1,105 @@
+#include <array>
 #include <cstring>
 #include <iostream>
+#include <type_traits>
+#include <unordered_map>
 
 #include "packet_assembler.h"
+#include "param_set.h"
+#include "runtime_config.h"
 
+// Bitmap dei frammenti ricevuti: dentro il messaggio con un insieme di parametri fisso, altrimenti
+// dimensionata sul messaggio
+template <class P, bool Fixed = P::fixed>
+struct ChunkBitmap {
+  using type = std::vector<uint64_t>;
+  static void clear(type &bitmap, uint32_t total_chunks) { bitmap.assign((total_chunks + 63) / 64, 0); }
+};
+
+template <class P>
+struct ChunkBitmap<P, true> {
+  using type = std::array<uint64_t, P::bitmap_words>;
+  static void clear(type &bitmap, uint32_t) { bitmap.fill(0); }
+};
+
+template <class P>
+class BasicAssembler : public PacketAssembler::Impl {
+public:
+  // Struttura necessaria per tenere traccia di più pacchetti contemporaneamente
+  struct MessageInfo {
+    bool active = false;
+    uint32_t total_chunks = 0;
+    uint32_t size = 0;
+    uint32_t received_count = 0;
+    std::vector<char> data;
+    typename ChunkBitmap<P>::type chunk_received;
+  };
+
+  PacketAssembler::AssemblyResult process_packet(const char *packet, size_t packet_size) override;
+
+  void reset(uint32_t message_id) override { messages.erase(message_id); }
+  bool contains(uint32_t message_id) const override { return messages.count(message_id) != 0; }
+  size_t in_flight() const override { return messages.size(); }
+
+private:
+  std::unordered_map<uint32_t, MessageInfo> messages;
+};
+
+template <class P>
 PacketAssembler::AssemblyResult
-// Ogni chiamata non alloca nuova memoria: assign non alloca nuova memoria se ne ha già abbastanza
-// dopo che è stato fatto il clear nel metodo reset() (che non dealloca)
-PacketAssembler::process_packet(const char *packet, size_t packet_size) {
-  AssemblyResult result{false, 0, {}};
+// Il buffer di ogni messaggio viene allocato al primo frammento e alla fine spostato in AssemblyResult
+// (senza copia): un messaggio nuovo alloca sempre un buffer nuovo
+BasicAssembler<P>::process_packet(const char *packet, size_t packet_size) {
+  PacketAssembler::AssemblyResult result{false, 0, {}};
 
-  if (packet_size < sizeof(TelemetryHeader))
+  // Frammenti incoerenti con l'header o con i parametri vengono ignorati
+  FragmentInfo hdr;
+  if (!parse_fragment_header(packet, packet_size, hdr))
     return result;
-
-  TelemetryHeader hdr;
-  memcpy(&hdr, packet, sizeof(TelemetryHeader));
-
-  // Sistema per liberare memoria quando ci sono troppi messaggi incompleti
-  /*auto it = messages.find(hdr.message_id);
-  // Se è un nuovo messaggio e ci sono troppi messaggi incompleti, libera spazio (costo O(1))
-  if (it == messages.end()) {
-      if (messages.size() > 100) {
-          // Rimuoviamo un blocco di messaggi (es. 20) per non doverlo rifare subito
-          auto erase_it = messages.begin();
-          int count = 0;
-          while (erase_it != messages.end() && count < 80) {
-              erase_it = messages.erase(erase_it);
-              count++;
-          }
-      }
-      it = messages.emplace(hdr.message_id, MessageInfo{}).first;
-  }*/
+  if constexpr (P::fixed) {
+    if (hdr.total_chunks > P::max_chunks || hdr.total_size > P::max_message_bytes) {
+      std::cerr << "Errore: messaggio " << hdr.message_id << " più grande del massimo per grado " << P::degree << std::endl;
+      return result;
+    }
+  }
 
   auto it = messages.emplace(hdr.message_id, MessageInfo{}).first;
   MessageInfo& msg = it->second;
-  
+
   // In caso il messaggio non era ancora mai arrivato
   if (!msg.active) {
     msg.active = true;
     msg.total_chunks = hdr.total_chunks;
-    msg.size = hdr.ciphertext_total_size;
+    msg.size = hdr.total_size;
     msg.received_count = 0;
     msg.data.assign(msg.size, 0);
-    msg.chunk_received.assign(msg.total_chunks, false);
+    ChunkBitmap<P>::clear(msg.chunk_received, msg.total_chunks);
   }
+  if (hdr.chunk_index >= msg.total_chunks)
+    return result;
 
   // Calcola posizione e dimensione
-  size_t pos = hdr.chunk_index * CHUNK_SIZE;
+  size_t pos = (size_t)hdr.chunk_index * P::chunk_size;
   size_t dim = hdr.chunk_size;
 
   // Controlla se proverebbe a scrivere oltre il buffer
   if (pos + dim > msg.data.size()) {
     std::cerr << "Errore: tentativo di scrivere oltre il buffer" << std::endl;
+    if (pos >= msg.data.size())
+      return result;
     dim = msg.data.size() - pos;
   }
 
   // Copia solo se chunk non è già stato ricevuto
-  if (!msg.chunk_received[hdr.chunk_index]) {
-    memcpy(msg.data.data() + pos, packet + sizeof(TelemetryHeader), dim);
-    msg.chunk_received[hdr.chunk_index] = true;
+  uint64_t &word = msg.chunk_received[hdr.chunk_index / 64];
+  uint64_t bit = 1ull << (hdr.chunk_index % 64);
+  if (!(word & bit)) {
+    // Tutti i chunk tranne l'ultimo sono pieni: copia a lunghezza costante, srotolata dal compilatore
+    if (dim == P::chunk_size)
+      memcpy(msg.data.data() + pos, packet + hdr.header_size, P::chunk_size);
+    else
+      memcpy(msg.data.data() + pos, packet + hdr.header_size, dim);
+    word |= bit;
     msg.received_count++;
   }
 
@@ -72,6 +114,17 @@ PacketAssembler::process_packet(const char *packet, size_t packet_size) {
   return result;
 }
 
-void PacketAssembler::reset(uint32_t message_id) {
-  messages.erase(message_id);  
+PacketAssembler::PacketAssembler(size_t poly_modulus_degree, size_t ct_moduli) {
+  if (poly_modulus_degree == 0)
+    poly_modulus_degree = runtime_config().poly_modulus_degree;
+
+  impl = dispatch_param_set(poly_modulus_degree, [ct_moduli](auto params) -> std::unique_ptr<Impl> {
+    using P = decltype(params);
+    // Con coeff modulus diversi da quelli di default (seal.parms) i limiti di P non valgono
+    if constexpr (P::fixed) {
+      if (ct_moduli != 0 && ct_moduli != P::ct_moduli)
+        return std::unique_ptr<Impl>(new BasicAssembler<DynamicParamSet>());
+    }
+    return std::unique_ptr<Impl>(new BasicAssembler<P>());
+  });
 }
@@ -2,11 +2,15 @@
 #define PACKET_ASSEMBLER_H
 
 #include "message.h"
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
-#include <unordered_map>
 
-// Classe per l'assemblaggio di chunk in un messaggio (in ricezione)
+// Classe per l'assemblaggio di chunk in un messaggio (in ricezione).
+// L'implementazione è specializzata a compile time per i gradi di param_set.h (bitmap dei frammenti a
+// dimensione fissa, copia dei chunk pieni a lunghezza costante, messaggi oltre il massimo scartati) e
+// scelta alla costruzione dal grado; per gli altri gradi si usa quella generica
 class PacketAssembler {
 public:
   // Risultato dell'elaborazione di un pacchetto
@@ -16,26 +20,34 @@ public:
     std::vector<char> data; // Se il messaggio è stato completato contiene i dati assemblati
   };
 
-  // Struttura necessaria per tenere traccia di più pacchetti contemporaneamente
-  struct MessageInfo {
-    bool active = false;
-    uint16_t total_chunks = 0;
-    uint32_t size = 0;
-    uint32_t received_count = 0;
-    std::vector<char> data;
-    std::vector<bool> chunk_received;
+  // Interfaccia delle implementazioni (vedi packet_assembler.cpp)
+  class Impl {
+  public:
+    virtual ~Impl() = default;
+    virtual AssemblyResult process_packet(const char *packet, size_t packet_size) = 0;
+    virtual void reset(uint32_t message_id) = 0;
+    virtual bool contains(uint32_t message_id) const = 0;
+    virtual size_t in_flight() const = 0;
   };
 
-  PacketAssembler() = default;
+  // poly_modulus_degree = 0: grado di runtime_config(). ct_moduli = moduli del ciphertext (vedi
+  // ciphertext_moduli() in seal_params.h), 0 = quelli di default di SEAL per il grado
+  explicit PacketAssembler(size_t poly_modulus_degree = 0, size_t ct_moduli = 0);
 
   // Processa un pacchetto ricevuto (buffer con header + payload)
-  AssemblyResult process_packet(const char *packet, size_t packet_size);
+  AssemblyResult process_packet(const char *packet, size_t packet_size) { return impl->process_packet(packet, packet_size); }
 
   // Resetta lo stato per un determinato messaggio
-  void reset(uint32_t message_id);
+  void reset(uint32_t message_id) { impl->reset(message_id); }
+
+  // Vero se del messaggio è già arrivato almeno un frammento (e non è ancora completo)
+  bool contains(uint32_t message_id) const { return impl->contains(message_id); }
+
+  // Messaggi con almeno un frammento ricevuto e non ancora completati
+  size_t in_flight() const { return impl->in_flight(); }
 
 private:
-  std::unordered_map<uint32_t, MessageInfo> messages;
+  std::unique_ptr<Impl> impl;
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef PACKET_IO_H
+#define PACKET_IO_H
+
+#include <cstdint>
+
+// Massimo numero di pacchetti restituiti da una singola rx_burst (dimensione degli array temporanei).
+// tx_burst, alloc_bulk e free_bulk accettano qualsiasi numero di pacchetti
+constexpr uint16_t PACKET_IO_MAX_BURST = 256;
+
+// Spazio minimo garantito nei buffer dei backend: basta per Ethernet + IPv4 + UDP + frammento di telemetria
+constexpr uint16_t PACKET_IO_BUF_SIZE = 1536;
+
+// Pacchetto visto dal datapath, indipendente dal backend
+struct Packet {
+    uint8_t *data;  // Inizio del frame Ethernet
+    uint16_t len;   // Lunghezza del frame (da impostare prima di tx_burst per i pacchetti allocati)
+    void *handle;   // Buffer del backend (rte_mbuf, buffer AF_PACKET, ...)
+};
+
+// Interfaccia per l'I/O dei pacchetti del forwarder. Il datapath (riassemblaggio, HE, frammentazione)
+// usa solo questa interfaccia, così lo stesso codice gira sulla DPU (DOCA/DPDK), su device virtuali
+// DPDK (net_ring, net_pcap, net_null) e su qualsiasi macchina Linux (AF_PACKET).
+// Le porte sono numerate come in DPDK (0 = ingress, 1 = egress), le code sono per thread.
+// Un pacchetto ricevuto o allocato appartiene al chiamante finché non viene passato a tx_burst
+// (se accettato) o a free_bulk
+class PacketIO {
+public:
+    virtual ~PacketIO() = default;
+
+    // Riceve fino a n pacchetti (al massimo PACKET_IO_MAX_BURST) dalla coda queue della porta port
+    virtual uint16_t rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) = 0;
+
+    // Trasmette i pacchetti in ordine. Ritorna quanti ne sono stati accettati: i primi pkts[0..ret)
+    // passano al backend, quelli rimanenti restano al chiamante
+    virtual uint32_t tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) = 0;
+
+    // Alloca n buffer vuoti (len = 0, almeno PACKET_IO_BUF_SIZE byte) da trasmettere su port/queue.
+    // Tutto o niente
+    virtual bool alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) = 0;
+
+    // Restituisce i buffer al backend
+    virtual void free_bulk(Packet *pkts, uint32_t n) = 0;
+
+    // Pacchetti in attesa nella coda di ricezione, negativo se il backend non lo supporta
+    virtual int rx_queue_count(uint16_t port, uint16_t queue) = 0;
+
+    virtual const char *name() const = 0;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "packet_io_afpacket.h"
+
+// Buffer allocati per ogni coda (più quelli per i pacchetti generati dal forwarder)
+constexpr size_t AFPACKET_BUFS_PER_QUEUE = 4096;
+
+AfPacketIO::~AfPacketIO() {
+    close();
+}
+
+bool AfPacketIO::open(const std::vector<std::string> &ifaces, uint16_t nb_queues) {
+    queues.assign(ifaces.size(), std::vector<Queue>(nb_queues));
+
+    for (size_t port = 0; port < ifaces.size(); port++) {
+        int ifindex = if_nametoindex(ifaces[port].c_str());
+        if (ifindex == 0) {
+            std::cerr << "Interfaccia non trovata: " << ifaces[port] << std::endl;
+            close();
+            return false;
+        }
+
+        // Un gruppo di fanout per porta: le code della stessa porta si dividono i pacchetti
+        int fanout_group = (getpid() + port) & 0xffff;
+
+        for (uint16_t q = 0; q < nb_queues; q++) {
+            int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+            if (fd < 0) {
+                perror("socket AF_PACKET");
+                close();
+                return false;
+            }
+            queues[port][q].fd = fd;
+
+            sockaddr_ll sll;
+            memset(&sll, 0, sizeof(sll));
+            sll.sll_family = AF_PACKET;
+            sll.sll_protocol = htons(ETH_P_ALL);
+            sll.sll_ifindex = ifindex;
+            if (bind(fd, (sockaddr *)&sll, sizeof(sll)) < 0) {
+                perror("bind AF_PACKET");
+                close();
+                return false;
+            }
+
+            // Non ricevere i pacchetti trasmessi da questa macchina (altrimenti il forwarder rivede i propri)
+            int one = 1;
+            if (setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one)) < 0)
+                std::cerr << "Warning: PACKET_IGNORE_OUTGOING non supportato" << std::endl;
+
+            packet_mreq mreq;
+            memset(&mreq, 0, sizeof(mreq));
+            mreq.mr_ifindex = ifindex;
+            mreq.mr_type = PACKET_MR_PROMISC;
+            if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+                std::cerr << "Warning: impossibile attivare la modalità promiscua su " << ifaces[port] << std::endl;
+
+            // Hash sul flow come l'RSS: i frammenti inviati dalla stessa porta sorgente finiscono sulla stessa coda
+            int fanout = fanout_group | (PACKET_FANOUT_HASH << 16);
+            if (nb_queues > 1 && setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+                perror("PACKET_FANOUT");
+                close();
+                return false;
+            }
+        }
+    }
+
+    // Pre allocazione di tutti i buffer: durante il polling non viene allocata nuova memoria
+    size_t n_bufs = AFPACKET_BUFS_PER_QUEUE * ifaces.size() * nb_queues;
+    storage.reserve(n_bufs);
+    free_bufs.reserve(n_bufs);
+    for (size_t i = 0; i < n_bufs; i++) {
+        storage.emplace_back(new uint8_t[PACKET_IO_BUF_SIZE]);
+        free_bufs.push_back(storage.back().get());
+    }
+
+    return true;
+}
+
+void AfPacketIO::close() {
+    for (auto &port : queues) {
+        for (auto &q : port) {
+            if (q.fd >= 0)
+                ::close(q.fd);
+            q.fd = -1;
+        }
+    }
+    queues.clear();
+}
+
+uint16_t AfPacketIO::rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) {
+    Queue &q = queues[port][queue];
+    n = std::min(n, PACKET_IO_MAX_BURST);
+
+    // Ricarica i buffer della coda solo quando non bastano per un burst intero
+    if (q.spare.size() < n) {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        while (q.spare.size() < 2 * PACKET_IO_MAX_BURST && !free_bufs.empty()) {
+            q.spare.push_back(free_bufs.back());
+            free_bufs.pop_back();
+        }
+        n = std::min<size_t>(n, q.spare.size());
+        if (n == 0)
+            return 0;
+    }
+
+    mmsghdr msgs[PACKET_IO_MAX_BURST];
+    iovec iovs[PACKET_IO_MAX_BURST];
+    for (uint16_t i = 0; i < n; i++) {
+        iovs[i].iov_base = q.spare[q.spare.size() - 1 - i];
+        iovs[i].iov_len = PACKET_IO_BUF_SIZE;
+        memset(&msgs[i], 0, sizeof(mmsghdr));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int nb_rx = recvmmsg(q.fd, msgs, n, MSG_DONTWAIT, nullptr);
+    if (nb_rx <= 0)
+        return 0;
+
+    for (int i = 0; i < nb_rx; i++) {
+        pkts[i].data = (uint8_t *)iovs[i].iov_base;
+        // Frame più lunghi del buffer vengono troncati da recvmmsg: il datapath li scarta dai controlli sulle lunghezze
+        pkts[i].len = std::min<uint32_t>(msgs[i].msg_len, PACKET_IO_BUF_SIZE);
+        pkts[i].handle = iovs[i].iov_base;
+    }
+    q.spare.resize(q.spare.size() - nb_rx);
+    return nb_rx;
+}
+
+uint32_t AfPacketIO::tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) {
+    Queue &q = queues[port][queue];
+    mmsghdr msgs[PACKET_IO_MAX_BURST];
+    iovec iovs[PACKET_IO_MAX_BURST];
+
+    uint32_t sent = 0;
+    while (sent < n) {
+        uint32_t count = std::min<uint32_t>(n - sent, PACKET_IO_MAX_BURST);
+        for (uint32_t i = 0; i < count; i++) {
+            iovs[i].iov_base = pkts[sent + i].data;
+            iovs[i].iov_len = pkts[sent + i].len;
+            memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int nb_tx = sendmmsg(q.fd, msgs, count, MSG_DONTWAIT);
+        if (nb_tx <= 0)
+            break;
+
+        // Il kernel ha già copiato i dati: i buffer tornano subito nel pool
+        free_bulk(pkts + sent, nb_tx);
+        sent += nb_tx;
+        if ((uint32_t)nb_tx < count)
+            break;
+    }
+    return sent;
+}
+
+bool AfPacketIO::alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) {
+    (void)port;
+    (void)queue;
+    std::lock_guard<std::mutex> lock(pool_mtx);
+    if (free_bufs.size() < n)
+        return false;
+
+    for (uint32_t i = 0; i < n; i++) {
+        pkts[i].data = free_bufs.back();
+        pkts[i].len = 0;
+        pkts[i].handle = free_bufs.back();
+        free_bufs.pop_back();
+    }
+    return true;
+}
+
+void AfPacketIO::free_bulk(Packet *pkts, uint32_t n) {
+    std::lock_guard<std::mutex> lock(pool_mtx);
+    for (uint32_t i = 0; i < n; i++)
+        free_bufs.push_back((uint8_t *)pkts[i].handle);
+}
+
+int AfPacketIO::rx_queue_count(uint16_t port, uint16_t queue) {
+    (void)port;
+    (void)queue;
+    // Il kernel non espone il numero di pacchetti in coda su un socket AF_PACKET senza ring mmap
+    return -1;
+}
+
+const char *AfPacketIO::name() const {
+    return "afpacket";
+}
@@ -0,0 +1,47 @@
+#ifndef PACKET_IO_AFPACKET_H
+#define PACKET_IO_AFPACKET_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "packet_io.h"
+
+// Backend AF_PACKET: permette di far girare il datapath completo su qualsiasi macchina Linux
+// (es. su una coppia di veth), senza DPDK né DOCA. Ogni interfaccia è una porta; per ogni porta
+// vengono aperti nb_queues socket nello stesso gruppo PACKET_FANOUT con hash sul flow, che fa
+// lo stesso lavoro dell'RSS sulla NIC: ogni coda viene servita da un solo thread
+class AfPacketIO : public PacketIO {
+public:
+    AfPacketIO() = default;
+    ~AfPacketIO() override;
+
+    // Apre i socket. Ritorna false in caso di errore (servono CAP_NET_RAW e interfacce esistenti)
+    bool open(const std::vector<std::string> &ifaces, uint16_t nb_queues);
+    void close();
+
+    uint16_t rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) override;
+    uint32_t tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    bool alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    void free_bulk(Packet *pkts, uint32_t n) override;
+    int rx_queue_count(uint16_t port, uint16_t queue) override;
+    const char *name() const override;
+
+private:
+    // Stato di una coda: usato solo dal thread che la serve
+    struct Queue {
+        int fd = -1;
+        std::vector<uint8_t *> spare;  // Buffer pronti per recvmmsg, riempiti dal pool solo quando servono
+    };
+
+    std::vector<std::vector<Queue>> queues;  // [porta][coda]
+
+    // Pool di buffer condiviso tra i thread (un pacchetto può essere liberato da un thread diverso
+    // da quello che l'ha ricevuto). Il lock viene preso al massimo una volta per burst
+    std::mutex pool_mtx;
+    std::vector<uint8_t *> free_bufs;
+    std::vector<std::unique_ptr<uint8_t[]>> storage;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <rte_telemetry.h>
+#include <rte_version.h>
+
+#include "forwarder_stats.h"
+#include "packet_io_dpdk.h"
+
+DpdkPacketIO::DpdkPacketIO(struct rte_mempool *pool)
+    : pool(pool)
+{
+}
+
+uint16_t DpdkPacketIO::rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n)
+{
+    // rte_eth_rx_burst non alloca nuova memoria: prende gli mbuf già presenti nella RX queue
+    uint16_t nb_rx = rte_eth_rx_burst(port, queue, mbufs, std::min(n, PACKET_IO_MAX_BURST));
+    for (uint16_t i = 0; i < nb_rx; i++) {
+        pkts[i].data = rte_pktmbuf_mtod(mbufs[i], uint8_t *);
+        pkts[i].len = rte_pktmbuf_data_len(mbufs[i]);
+        pkts[i].handle = mbufs[i];
+    }
+    return nb_rx;
+}
+
+uint32_t DpdkPacketIO::tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n)
+{
+    uint32_t sent = 0;
+    while (sent < n) {
+        uint16_t count = std::min<uint32_t>(n - sent, PACKET_IO_MAX_BURST);
+        for (uint16_t i = 0; i < count; i++) {
+            struct rte_mbuf *m = (struct rte_mbuf *)pkts[sent + i].handle;
+            // Lunghezza dati in questo mbuf e lunghezza pacchetto (che può essere distribuito su più mbuf)
+            m->data_len = pkts[sent + i].len;
+            m->pkt_len = pkts[sent + i].len;
+            mbufs[i] = m;
+        }
+        // rte_eth_tx_burst si occupa di liberare gli mbuf accettati dopo la trasmissione
+        uint16_t nb_tx = rte_eth_tx_burst(port, queue, mbufs, count);
+        sent += nb_tx;
+        if (nb_tx < count)
+            break;
+    }
+    return sent;
+}
+
+bool DpdkPacketIO::alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n)
+{
+    (void)port;
+    (void)queue;
+    uint32_t done = 0;
+    while (done < n) {
+        uint16_t count = std::min<uint32_t>(n - done, PACKET_IO_MAX_BURST);
+        // Bulk alloc, per evitare di allocare gli mbuf uno alla volta
+        if (rte_pktmbuf_alloc_bulk(pool, mbufs, count) != 0) {
+            alloc_failures++;
+            free_bulk(pkts, done);
+            return false;
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            pkts[done + i].data = rte_pktmbuf_mtod(mbufs[i], uint8_t *);
+            pkts[done + i].len = 0;
+            pkts[done + i].handle = mbufs[i];
+        }
+        done += count;
+    }
+    return true;
+}
+
+void DpdkPacketIO::free_bulk(Packet *pkts, uint32_t n)
+{
+    uint32_t done = 0;
+    while (done < n) {
+        uint16_t count = std::min<uint32_t>(n - done, PACKET_IO_MAX_BURST);
+        for (uint16_t i = 0; i < count; i++)
+            mbufs[i] = (struct rte_mbuf *)pkts[done + i].handle;
+        rte_pktmbuf_free_bulk(mbufs, count);
+        done += count;
+    }
+}
+
+int DpdkPacketIO::rx_queue_count(uint16_t port, uint16_t queue)
+{
+    return rte_eth_rx_queue_count(port, queue);
+}
+
+const char *DpdkPacketIO::name() const
+{
+    return "dpdk";
+}
+
+int configure_dpdk_port(uint16_t port_id, uint16_t nb_queues, uint16_t rx_ring_size,
+                        uint16_t tx_ring_size, struct rte_mempool *pool)
+{
+    struct rte_eth_conf port_conf;
+    int ret;
+
+    memset(&port_conf, 0, sizeof(port_conf));
+
+    ret = rte_eth_dev_configure(port_id, nb_queues, nb_queues, &port_conf);
+    if (ret < 0)
+        return ret;
+
+    for (uint16_t q = 0; q < nb_queues; ++q) {
+        ret = rte_eth_rx_queue_setup(port_id, q, rx_ring_size, rte_eth_dev_socket_id(port_id), nullptr, pool);
+        if (ret < 0)
+            return ret;
+        ret = rte_eth_tx_queue_setup(port_id, q, tx_ring_size, rte_eth_dev_socket_id(port_id), nullptr);
+        if (ret < 0)
+            return ret;
+    }
+
+    // I device virtuali possono non supportare la modalità promiscua: non è un errore
+    ret = rte_eth_promiscuous_enable(port_id);
+    if (ret < 0 && ret != -ENOTSUP)
+        std::cerr << "Warning: modalità promiscua non attivata sulla porta " << port_id << std::endl;
+
+    return rte_eth_dev_start(port_id);
+}
+
+static int stats_telemetry_cb(const char *cmd, const char *params, struct rte_tel_data *d)
+{
+    (void)cmd;
+
+    StatsSnapshot snap;
+    if (params != nullptr && params[0] != '\0') {
+        char *end = nullptr;
+        unsigned long lcore = strtoul(params, &end, 10);
+        if (*end != '\0' || lcore >= stats_lcore_count())
+            return -EINVAL;
+        snap = read_lcore_stats(lcore);
+    } else {
+        snap = read_total_stats();
+    }
+
+    rte_tel_data_start_dict(d);
+    rte_tel_data_add_dict_int(d, "lcores", stats_lcore_count());
+    for (unsigned s = 0; s < N_STATS; s++) {
+#if RTE_VERSION >= RTE_VERSION_NUM(23, 3, 0, 0)
+        rte_tel_data_add_dict_uint(d, STAT_NAMES[s], snap[s]);
+#else
+        rte_tel_data_add_dict_u64(d, STAT_NAMES[s], snap[s]);
+#endif
+    }
+    return 0;
+}
+
+int register_stats_telemetry()
+{
+    return rte_telemetry_register_cmd("/forwarder/stats", stats_telemetry_cb,
+                                      "Forwarder datapath counters. Parameters: int lcore index (optional, default all)");
+}
@@ -0,0 +1,43 @@
+#ifndef PACKET_IO_DPDK_H
+#define PACKET_IO_DPDK_H
+
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+
+#include "packet_io.h"
+
+// Backend DPDK: usato sia sulla DPU (porte configurate con DOCA Flow) sia con i device
+// virtuali (--vdev=net_ring0, net_pcap0,..., net_null0). Una istanza per lcore
+class DpdkPacketIO : public PacketIO {
+public:
+    // I pacchetti generati dal forwarder vengono allocati da pool
+    explicit DpdkPacketIO(struct rte_mempool *pool);
+
+    uint16_t rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) override;
+    uint32_t tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    bool alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    void free_bulk(Packet *pkts, uint32_t n) override;
+    int rx_queue_count(uint16_t port, uint16_t queue) override;
+    const char *name() const override;
+
+    // Numero di alloc_bulk fallite per pool vuoto
+    uint64_t get_alloc_failures() const { return alloc_failures; }
+
+private:
+    struct rte_mempool *pool;
+    uint64_t alloc_failures = 0;
+    struct rte_mbuf *mbufs[PACKET_IO_MAX_BURST];  // Array temporaneo per le chiamate DPDK
+};
+
+// Configura e avvia una porta DPDK senza DOCA Flow (device virtuali e NIC generiche):
+// nb_queues code RX/TX con le dimensioni indicate, modalità promiscua
+int configure_dpdk_port(uint16_t port_id, uint16_t nb_queues, uint16_t rx_ring_size,
+                        uint16_t tx_ring_size, struct rte_mempool *pool);
+
+// Espone le statistiche del forwarder (forwarder_stats.h) sul socket di telemetria DPDK:
+// "/forwarder/stats" restituisce i totali, "/forwarder/stats,<indice lcore>" quelle di un lcore.
+// Si leggono con dpdk-telemetry.py mentre il forwarder è in esecuzione
+int register_stats_telemetry();
+
+#endif
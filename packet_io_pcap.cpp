@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+#include "message.h"
+#include "packet_io_pcap.h"
+
+// Formato pcap classico (https://wiki.wireshark.org/Development/LibpcapFileFormat), senza libpcap
+namespace {
+constexpr uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;   // Timestamp in microsecondi
+constexpr uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;   // Timestamp in nanosecondi
+constexpr uint32_t PCAP_LINKTYPE_ETHERNET = 1;
+
+struct PcapFileHeader {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct PcapRecordHeader {
+    uint32_t ts_sec;
+    uint32_t ts_frac;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+}
+
+// Offset del TelemetryHeader se il frame è un frammento UDP/IPv4, altrimenti 0
+static size_t telemetry_offset(const std::vector<uint8_t> &frame)
+{
+    if (frame.size() < sizeof(struct ether_header) + sizeof(struct iphdr))
+        return 0;
+    const struct ether_header *eth = (const struct ether_header *)frame.data();
+    if (eth->ether_type != htons(ETHERTYPE_IP))
+        return 0;
+    const struct iphdr *ip = (const struct iphdr *)(eth + 1);
+    if (ip->protocol != IPPROTO_UDP)
+        return 0;
+    size_t offset = sizeof(struct ether_header) + ip->ihl * 4 + sizeof(struct udphdr);
+    if (offset + sizeof(TelemetryHeader) > frame.size())
+        return 0;
+    return offset;
+}
+
+bool PcapReplayIO::open(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossibile aprire " << path << std::endl;
+        return false;
+    }
+
+    PcapFileHeader hdr;
+    if (!file.read((char *)&hdr, sizeof(hdr)) || (hdr.magic != PCAP_MAGIC_US && hdr.magic != PCAP_MAGIC_NS)) {
+        std::cerr << path << ": non è un file pcap (o ha un ordine dei byte diverso da questa macchina)" << std::endl;
+        return false;
+    }
+    if (hdr.linktype != PCAP_LINKTYPE_ETHERNET) {
+        std::cerr << path << ": link type " << hdr.linktype << " non supportato (solo Ethernet)" << std::endl;
+        return false;
+    }
+
+    frames.clear();
+    id_span = 0;
+    PcapRecordHeader rec;
+    while (file.read((char *)&rec, sizeof(rec))) {
+        Frame frame;
+        frame.data.resize(rec.incl_len);
+        if (!file.read((char *)frame.data.data(), rec.incl_len)) {
+            std::cerr << path << ": record troncato" << std::endl;
+            return false;
+        }
+        if (rec.incl_len > PACKET_IO_BUF_SIZE)
+            continue;  // Un backend reale non lo riceverebbe (niente jumbo frame)
+
+        frame.tel_offset = telemetry_offset(frame.data);
+        if (frame.tel_offset > 0) {
+            memcpy(&frame.message_id, frame.data.data() + frame.tel_offset, sizeof(frame.message_id));
+            id_span = std::max(id_span, frame.message_id + 1);
+        }
+        frames.push_back(std::move(frame));
+    }
+
+    if (frames.empty()) {
+        std::cerr << path << ": nessun frame" << std::endl;
+        return false;
+    }
+
+    loop = 0;
+    next = 0;       // Il primo giro usa i message_id del file
+    served = 0;
+    started = false;
+    return true;
+}
+
+void PcapReplayIO::start_loop()
+{
+    for (auto &frame : frames) {
+        if (frame.tel_offset == 0)
+            continue;
+        uint32_t id = frame.message_id + loop * id_span;
+        memcpy(frame.data.data() + frame.tel_offset, &id, sizeof(id));
+    }
+    next = 0;
+}
+
+uint16_t PcapReplayIO::rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n)
+{
+    (void)queue;
+    if (port != 0 || done() || frames.empty())
+        return 0;
+
+    if (!started) {
+        started = true;
+        start_time = std::chrono::steady_clock::now();
+    }
+    // I frame vengono riscritti solo qui: quelli del burst precedente sono già stati elaborati
+    if (next == frames.size())
+        start_loop();
+
+    // Con un rate fissato si restituiscono solo i frame "arrivati" fino a questo istante
+    if (rate_pps > 0) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        uint64_t arrived = (uint64_t)(elapsed * rate_pps);
+        if (arrived <= served)
+            return 0;
+        n = (uint16_t)std::min<uint64_t>(n, arrived - served);
+    }
+
+    // Un burst non attraversa la fine del file. I frame vengono copiati nei buffer di ricezione come
+    // farebbe la NIC: il forwarder può modificarli sul posto (cut-through) senza alterare il file caricato
+    if (rx_buffers.size() < n)
+        rx_buffers.resize(n);
+    uint16_t nb_rx = 0;
+    while (nb_rx < n && next < frames.size()) {
+        Frame &frame = frames[next++];
+        memcpy(rx_buffers[nb_rx].data, frame.data.data(), frame.data.size());
+        pkts[nb_rx].data = rx_buffers[nb_rx].data;
+        pkts[nb_rx].len = frame.data.size();
+        pkts[nb_rx].handle = nullptr;
+        nb_rx++;
+    }
+    if (next == frames.size())
+        loop++;
+    served += nb_rx;
+    return nb_rx;
+}
+
+uint32_t PcapReplayIO::tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n)
+{
+    (void)port;
+    (void)queue;
+    for (uint32_t i = 0; i < n; i++)
+        tx_bytes += pkts[i].len;
+    tx_pkts += n;
+    return n;
+}
+
+bool PcapReplayIO::alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n)
+{
+    (void)port;
+    (void)queue;
+    // tx_burst consuma subito i pacchetti: gli stessi buffer servono a ogni risposta
+    if (tx_buffers.size() < n)
+        tx_buffers.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        pkts[i].data = tx_buffers[i].data;
+        pkts[i].len = 0;
+        pkts[i].handle = nullptr;
+    }
+    return true;
+}
+
+void PcapReplayIO::free_bulk(Packet *pkts, uint32_t n)
+{
+    // I buffer di ricezione e di trasmissione vengono riusati a ogni burst
+    (void)pkts;
+    (void)n;
+}
+
+int PcapReplayIO::rx_queue_count(uint16_t port, uint16_t queue)
+{
+    (void)port;
+    (void)queue;
+    return -1;
+}
+
+const char *PcapReplayIO::name() const
+{
+    return "pcap";
+}
+
+bool write_pcap(const std::string &path, const std::vector<std::vector<uint8_t>> &frames)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossibile creare " << path << std::endl;
+        return false;
+    }
+
+    PcapFileHeader hdr{PCAP_MAGIC_US, 2, 4, 0, 0, 65535, PCAP_LINKTYPE_ETHERNET};
+    file.write((const char *)&hdr, sizeof(hdr));
+
+    uint64_t ts_us = 0;
+    for (const auto &frame : frames) {
+        PcapRecordHeader rec{(uint32_t)(ts_us / 1000000), (uint32_t)(ts_us % 1000000),
+                             (uint32_t)frame.size(), (uint32_t)frame.size()};
+        file.write((const char *)&rec, sizeof(rec));
+        file.write((const char *)frame.data(), frame.size());
+        ts_us++;
+    }
+    return (bool)file;
+}
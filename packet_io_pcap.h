@@ -0,0 +1,70 @@
+#ifndef PACKET_IO_PCAP_H
+#define PACKET_IO_PCAP_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "packet_io.h"
+
+// Backend di replay per i test offline del forwarder: i frame di un file pcap vengono caricati in
+// memoria e restituiti da rx_burst sulla porta 0 (alla massima velocità o a un rate fissato), le
+// trasmissioni vengono contate e scartate. Una sola coda, da usare da un solo thread.
+// Ad ogni ripetizione del file i message_id vengono spostati oltre quelli del giro precedente, per cui
+// i messaggi incompleti (scenari con perdite) non si mescolano con quelli del giro successivo
+class PcapReplayIO : public PacketIO {
+public:
+    // Carica il file (formato pcap classico, Ethernet). Ritorna false in caso di errore
+    bool open(const std::string &path);
+
+    // pps = 0: massima velocità
+    void set_rate(uint64_t pps) { rate_pps = pps; }
+    void set_loops(uint32_t n) { loops = n; }
+
+    // Vero quando tutti i frame di tutte le ripetizioni sono stati restituiti
+    bool done() const { return loop >= loops; }
+
+    size_t frame_count() const { return frames.size(); }
+    uint64_t get_tx_pkts() const { return tx_pkts; }
+    uint64_t get_tx_bytes() const { return tx_bytes; }
+
+    uint16_t rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) override;
+    uint32_t tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    bool alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    void free_bulk(Packet *pkts, uint32_t n) override;
+    int rx_queue_count(uint16_t port, uint16_t queue) override;
+    const char *name() const override;
+
+private:
+    struct Frame {
+        std::vector<uint8_t> data;
+        size_t tel_offset = 0;     // Offset del TelemetryHeader (0 se il frame non è telemetria)
+        uint32_t message_id = 0;   // message_id originale
+    };
+
+    struct Buffer {
+        uint8_t data[PACKET_IO_BUF_SIZE];
+    };
+
+    // Inizio di una ripetizione (loop > 0): message_id spostati di loop * id_span
+    void start_loop();
+
+    std::vector<Frame> frames;
+    std::vector<Buffer> rx_buffers;
+    std::vector<Buffer> tx_buffers;
+    uint32_t id_span = 0;          // max message_id + 1
+    uint64_t rate_pps = 0;
+    uint32_t loops = 1;
+    uint32_t loop = 0;
+    size_t next = 0;               // Prossimo frame da restituire
+    uint64_t served = 0;           // Frame restituiti (per il rate)
+    bool started = false;
+    std::chrono::steady_clock::time_point start_time;
+    uint64_t tx_pkts = 0;
+    uint64_t tx_bytes = 0;
+};
+
+// Scrive i frame Ethernet in un file pcap (timestamp a 1 µs l'uno dall'altro)
+bool write_pcap(const std::string &path, const std::vector<std::vector<uint8_t>> &frames);
+
+#endif
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include "packet_io_xdp.h"
+#include "runtime_config.h"
+
+// Frame per coda: devono bastare per i fill ring e i TX ring di tutte le porte, più i frammenti in riassemblaggio
+constexpr uint32_t XDP_FRAMES_PER_QUEUE = 16384;
+constexpr uint32_t XDP_FRAME_SIZE = XSK_UMEM__DEFAULT_FRAME_SIZE;
+constexpr size_t XDP_UMEM_SIZE = (size_t)XDP_FRAMES_PER_QUEUE * XDP_FRAME_SIZE;
+// Il fill ring viene ricaricato solo quando mancano almeno questi frame, per non toccarlo a ogni burst
+constexpr uint32_t XDP_REFILL_BATCH = 64;
+
+static_assert(XDP_FRAME_SIZE >= PACKET_IO_BUF_SIZE + XDP_PACKET_HEADROOM, "Frame AF_XDP troppo piccoli");
+
+// Deve corrispondere a struct port_range in xdp_telemetry.bpf.c
+struct XdpPortRange {
+    uint16_t base_port;
+    uint16_t n_ports;
+};
+
+XdpPacketIO::~XdpPacketIO() {
+    close();
+}
+
+bool XdpPacketIO::open(const std::vector<std::string> &ifaces, uint16_t nb_queues, const std::string &bpf_obj_path) {
+    sockets.assign(ifaces.size(), std::vector<Socket>(nb_queues));
+    umems.assign(nb_queues, Umem());
+
+    // Programma XDP: uno per interfaccia, ognuno con la sua XSKMAP
+    std::vector<int> xsks_map_fds;
+    for (const auto &iface : ifaces) {
+        int ifindex = if_nametoindex(iface.c_str());
+        if (ifindex == 0) {
+            std::cerr << "Interfaccia non trovata: " << iface << std::endl;
+            close();
+            return false;
+        }
+
+        struct xdp_program *prog = xdp_program__open_file(bpf_obj_path.c_str(), "xdp", nullptr);
+        if (libxdp_get_error(prog)) {
+            std::cerr << "Impossibile aprire il programma XDP " << bpf_obj_path << std::endl;
+            close();
+            return false;
+        }
+        int err = xdp_program__attach(prog, ifindex, XDP_MODE_NATIVE, 0);
+        if (err) {
+            std::cerr << "Warning: XDP nativo non supportato su " << iface << ", uso la modalità generica" << std::endl;
+            err = xdp_program__attach(prog, ifindex, XDP_MODE_SKB, 0);
+        }
+        if (err) {
+            std::cerr << "Caricamento del programma XDP su " << iface << " fallito: " << strerror(-err) << std::endl;
+            xdp_program__close(prog);
+            close();
+            return false;
+        }
+        ifindexes.push_back(ifindex);
+        programs.push_back(prog);
+
+        struct bpf_object *obj = xdp_program__bpf_obj(prog);
+        int range_fd = bpf_object__find_map_fd_by_name(obj, "port_range_map");
+        int xsks_fd = bpf_object__find_map_fd_by_name(obj, "xsks_map");
+        if (range_fd < 0 || xsks_fd < 0) {
+            std::cerr << "Mappe mancanti in " << bpf_obj_path << std::endl;
+            close();
+            return false;
+        }
+
+        // Le porte da redirigere vengono dalla configurazione, così il programma non va ricompilato se cambiano
+        uint32_t key = 0;
+        XdpPortRange range{runtime_config().base_port, runtime_config().n_ports};
+        if (bpf_map_update_elem(range_fd, &key, &range, BPF_ANY) < 0) {
+            perror("bpf_map_update_elem port_range_map");
+            close();
+            return false;
+        }
+        xsks_map_fds.push_back(xsks_fd);
+    }
+
+    // Memoria delle UMEM, allocata tutta insieme: dall'indirizzo di un buffer si risale alla coda
+    area_size = XDP_UMEM_SIZE * nb_queues;
+    void *mem = mmap(nullptr, area_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap UMEM");
+        close();
+        return false;
+    }
+    area = (uint8_t *)mem;
+
+    struct xsk_umem_config umem_cfg;
+    memset(&umem_cfg, 0, sizeof(umem_cfg));
+    umem_cfg.fill_size = XSK_RING_PROD__DEFAULT_NUM_DESCS;
+    umem_cfg.comp_size = XSK_RING_CONS__DEFAULT_NUM_DESCS;
+    umem_cfg.frame_size = XDP_FRAME_SIZE;
+    umem_cfg.frame_headroom = XSK_UMEM__DEFAULT_FRAME_HEADROOM;
+
+    for (uint16_t q = 0; q < nb_queues; q++) {
+        Umem &u = umems[q];
+        u.area = area + q * XDP_UMEM_SIZE;
+
+        // Fill e completion ring passati alla creazione della UMEM vengono usati dalla prima socket (porta 0)
+        int err = xsk_umem__create(&u.umem, u.area, XDP_UMEM_SIZE, &sockets[0][q].fq, &sockets[0][q].cq, &umem_cfg);
+        if (err) {
+            std::cerr << "xsk_umem__create fallita per la coda " << q << ": " << strerror(-err) << std::endl;
+            close();
+            return false;
+        }
+
+        u.free_frames.reserve(XDP_FRAMES_PER_QUEUE);
+        for (uint32_t f = 0; f < XDP_FRAMES_PER_QUEUE; f++)
+            u.free_frames.push_back((uint64_t)f * XDP_FRAME_SIZE);
+
+        for (size_t port = 0; port < ifaces.size(); port++) {
+            Socket &s = sockets[port][q];
+
+            struct xsk_socket_config xsk_cfg;
+            memset(&xsk_cfg, 0, sizeof(xsk_cfg));
+            xsk_cfg.rx_size = XSK_RING_CONS__DEFAULT_NUM_DESCS;
+            xsk_cfg.tx_size = XSK_RING_PROD__DEFAULT_NUM_DESCS;
+            xsk_cfg.libxdp_flags = XSK_LIBXDP_FLAGS__INHIBIT_PROG_LOAD;  // Il programma è già caricato sopra
+            xsk_cfg.bind_flags = XDP_USE_NEED_WAKEUP | XDP_ZEROCOPY;
+
+            // Con la UMEM condivisa ogni socket ha i propri fill e completion ring
+            err = xsk_socket__create_shared(&s.xsk, ifaces[port].c_str(), q, u.umem,
+                                            &s.rx, &s.tx, &s.fq, &s.cq, &xsk_cfg);
+            if (err) {
+                std::cerr << "Warning: zero-copy non supportato su " << ifaces[port] << ":" << q
+                          << ", uso la modalità con copia" << std::endl;
+                xsk_cfg.bind_flags = XDP_USE_NEED_WAKEUP | XDP_COPY;
+                err = xsk_socket__create_shared(&s.xsk, ifaces[port].c_str(), q, u.umem,
+                                                &s.rx, &s.tx, &s.fq, &s.cq, &xsk_cfg);
+            }
+            if (err) {
+                std::cerr << "Creazione della socket AF_XDP " << ifaces[port] << ":" << q
+                          << " fallita: " << strerror(-err) << std::endl;
+                s.xsk = nullptr;
+                close();
+                return false;
+            }
+
+            err = xsk_socket__update_xskmap(s.xsk, xsks_map_fds[port]);
+            if (err) {
+                std::cerr << "xsk_socket__update_xskmap fallita: " << strerror(-err) << std::endl;
+                close();
+                return false;
+            }
+
+            refill(s, u);
+        }
+    }
+
+    return true;
+}
+
+void XdpPacketIO::close() {
+    for (auto &port : sockets) {
+        for (auto &s : port) {
+            if (s.xsk)
+                xsk_socket__delete(s.xsk);
+            s.xsk = nullptr;
+        }
+    }
+    sockets.clear();
+
+    for (auto &u : umems) {
+        if (u.umem)
+            xsk_umem__delete(u.umem);
+        u.umem = nullptr;
+    }
+    umems.clear();
+
+    for (size_t port = 0; port < programs.size(); port++) {
+        enum xdp_attach_mode mode = xdp_program__is_attached(programs[port], ifindexes[port]);
+        if (mode != XDP_MODE_UNSPEC)
+            xdp_program__detach(programs[port], ifindexes[port], mode, 0);
+        xdp_program__close(programs[port]);
+    }
+    programs.clear();
+    ifindexes.clear();
+
+    if (area)
+        munmap(area, area_size);
+    area = nullptr;
+    area_size = 0;
+}
+
+void XdpPacketIO::reclaim_completed(Socket &s, Umem &u) {
+    uint32_t idx;
+    uint32_t done = xsk_ring_cons__peek(&s.cq, XSK_RING_CONS__DEFAULT_NUM_DESCS, &idx);
+    for (uint32_t i = 0; i < done; i++) {
+        uint64_t addr = *xsk_ring_cons__comp_addr(&s.cq, idx + i);
+        u.free_frames.push_back(addr - addr % XDP_FRAME_SIZE);
+    }
+    if (done > 0)
+        xsk_ring_cons__release(&s.cq, done);
+}
+
+void XdpPacketIO::refill(Socket &s, Umem &u) {
+    uint32_t ring_free = xsk_prod_nb_free(&s.fq, XSK_RING_PROD__DEFAULT_NUM_DESCS);
+    uint32_t n = std::min<size_t>(ring_free, u.free_frames.size());
+    // Ricarica a blocchi, tranne quando il kernel è rimasto del tutto senza frame
+    if (n == 0 || (n < XDP_REFILL_BATCH && ring_free < XSK_RING_PROD__DEFAULT_NUM_DESCS))
+        return;
+
+    uint32_t idx;
+    if (xsk_ring_prod__reserve(&s.fq, n, &idx) != n)
+        return;
+    for (uint32_t i = 0; i < n; i++) {
+        *xsk_ring_prod__fill_addr(&s.fq, idx + i) = u.free_frames.back();
+        u.free_frames.pop_back();
+    }
+    xsk_ring_prod__submit(&s.fq, n);
+}
+
+bool XdpPacketIO::locate(const uint8_t *data, uint16_t &queue, uint64_t &frame) const {
+    if (data < area || data >= area + area_size)
+        return false;
+    size_t offset = data - area;
+    queue = offset / XDP_UMEM_SIZE;
+    frame = offset % XDP_UMEM_SIZE;
+    frame -= frame % XDP_FRAME_SIZE;
+    return true;
+}
+
+uint16_t XdpPacketIO::rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) {
+    Socket &s = sockets[port][queue];
+    Umem &u = umems[queue];
+    n = std::min(n, PACKET_IO_MAX_BURST);
+
+    refill(s, u);
+
+    uint32_t idx;
+    uint32_t nb_rx = xsk_ring_cons__peek(&s.rx, n, &idx);
+    if (nb_rx == 0) {
+        // Con XDP_USE_NEED_WAKEUP il kernel va svegliato quando il fill ring si è svuotato
+        if (xsk_ring_prod__needs_wakeup(&s.fq))
+            recvfrom(xsk_socket__fd(s.xsk), nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < nb_rx; i++) {
+        const struct xdp_desc *desc = xsk_ring_cons__rx_desc(&s.rx, idx + i);
+        uint8_t *data = (uint8_t *)xsk_umem__get_data(u.area, desc->addr);
+        pkts[i].data = data;
+        pkts[i].len = desc->len;
+        pkts[i].handle = data;
+    }
+    xsk_ring_cons__release(&s.rx, nb_rx);
+    return nb_rx;
+}
+
+uint32_t XdpPacketIO::tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) {
+    Socket &s = sockets[port][queue];
+    Umem &u = umems[queue];
+
+    reclaim_completed(s, u);
+
+    uint32_t reserved = std::min(n, xsk_prod_nb_free(&s.tx, n));
+    uint32_t idx;
+    if (reserved == 0 || xsk_ring_prod__reserve(&s.tx, reserved, &idx) != reserved)
+        return 0;
+
+    uint32_t count = reserved;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t owner;
+        uint64_t frame;
+        uint64_t addr;
+        if (locate(pkts[i].data, owner, frame) && owner == queue) {
+            // Zero copy: il frame è già nella UMEM della coda (stesso thread, qualsiasi porta)
+            addr = (pkts[i].data - u.area);
+        } else {
+            // Pacchetto di un'altra coda: copia in un frame di questa UMEM (caso raro)
+            if (u.free_frames.empty()) {
+                count = i;
+                break;
+            }
+            addr = u.free_frames.back();
+            u.free_frames.pop_back();
+            memcpy(u.area + addr, pkts[i].data, pkts[i].len);
+            free_bulk(&pkts[i], 1);
+        }
+
+        struct xdp_desc *desc = xsk_ring_prod__tx_desc(&s.tx, idx + i);
+        desc->addr = addr;
+        desc->len = pkts[i].len;
+    }
+
+    // I descrittori prenotati ma non scritti vengono restituiti al ring
+    if (count < reserved)
+        xsk_ring_prod__cancel(&s.tx, reserved - count);
+    if (count == 0)
+        return 0;
+    xsk_ring_prod__submit(&s.tx, count);
+
+    if (xsk_ring_prod__needs_wakeup(&s.tx))
+        sendto(xsk_socket__fd(s.xsk), nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+
+    return count;
+}
+
+bool XdpPacketIO::alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) {
+    Umem &u = umems[queue];
+    if (u.free_frames.size() < n)
+        reclaim_completed(sockets[port][queue], u);
+    if (u.free_frames.size() < n)
+        return false;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t *data = u.area + u.free_frames.back();
+        u.free_frames.pop_back();
+        pkts[i].data = data;
+        pkts[i].len = 0;
+        pkts[i].handle = data;
+    }
+    return true;
+}
+
+void XdpPacketIO::free_bulk(Packet *pkts, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t queue;
+        uint64_t frame;
+        if (locate((const uint8_t *)pkts[i].handle, queue, frame))
+            umems[queue].free_frames.push_back(frame);
+    }
+}
+
+int XdpPacketIO::rx_queue_count(uint16_t port, uint16_t queue) {
+    return xsk_cons_nb_avail(&sockets[port][queue].rx, XSK_RING_CONS__DEFAULT_NUM_DESCS);
+}
+
+const char *XdpPacketIO::name() const {
+    return "af_xdp";
+}
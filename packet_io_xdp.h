@@ -0,0 +1,67 @@
+#ifndef PACKET_IO_XDP_H
+#define PACKET_IO_XDP_H
+
+#include <string>
+#include <vector>
+#include <xdp/libxdp.h>
+#include <xdp/xsk.h>
+
+#include "packet_io.h"
+
+// Backend AF_XDP: prestazioni vicine a DPDK su NIC senza DOCA, lasciando il resto del traffico
+// allo stack del kernel. Su ogni interfaccia viene caricato xdp_telemetry.bpf.o, che redirige
+// alle socket AF_XDP solo l'UDP verso base_port..base_port+n_ports-1 (runtime_config()).
+// Le code sono quelle hardware della NIC (ethtool -L <if> combined <n>, oppure veth creata con
+// numrxqueues/numtxqueues): l'RSS della NIC fa la distribuzione come sulla DPU.
+// Ogni coda va servita da un solo thread, che deve anche restituire i pacchetti ricevuti o allocati
+// su quella coda (le free list non sono protette da lock)
+class XdpPacketIO : public PacketIO {
+public:
+    XdpPacketIO() = default;
+    ~XdpPacketIO() override;
+
+    // Carica il programma XDP e crea le socket. Prova prima zero-copy e modalità nativa, poi ripiega
+    // su copia e modalità generica (SKB). Ritorna false in caso di errore (servono CAP_NET_ADMIN e CAP_BPF)
+    bool open(const std::vector<std::string> &ifaces, uint16_t nb_queues, const std::string &bpf_obj_path);
+    void close();
+
+    uint16_t rx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint16_t n) override;
+    uint32_t tx_burst(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    bool alloc_bulk(uint16_t port, uint16_t queue, Packet *pkts, uint32_t n) override;
+    void free_bulk(Packet *pkts, uint32_t n) override;
+    int rx_queue_count(uint16_t port, uint16_t queue) override;
+    const char *name() const override;
+
+private:
+    // UMEM di una coda, condivisa dalle socket della stessa coda su tutte le porte: un frame ricevuto
+    // sull'ingress può essere trasmesso sull'egress senza copie
+    struct Umem {
+        struct xsk_umem *umem = nullptr;
+        uint8_t *area = nullptr;
+        std::vector<uint64_t> free_frames;  // Offset dei frame liberi nella UMEM
+    };
+
+    struct Socket {
+        struct xsk_socket *xsk = nullptr;
+        struct xsk_ring_cons rx;
+        struct xsk_ring_prod tx;
+        struct xsk_ring_prod fq;  // Fill ring: frame vuoti dati al kernel per la ricezione
+        struct xsk_ring_cons cq;  // Completion ring: frame trasmessi che tornano liberi
+    };
+
+    // Riporta nella free list i frame trasmessi dalla socket
+    void reclaim_completed(Socket &s, Umem &u);
+    // Dà al kernel frame vuoti per la ricezione
+    void refill(Socket &s, Umem &u);
+    // Coda e offset del frame a cui appartiene un buffer
+    bool locate(const uint8_t *data, uint16_t &queue, uint64_t &frame) const;
+
+    std::vector<Umem> umems;                  // [coda]
+    std::vector<std::vector<Socket>> sockets; // [porta][coda]
+    std::vector<int> ifindexes;               // [porta]
+    std::vector<struct xdp_program *> programs; // [porta]
+    uint8_t *area = nullptr;                  // Memoria di tutte le UMEM (una fetta per coda)
+    size_t area_size = 0;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef PARAM_SET_H
+#define PARAM_SET_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "message.h"
+
+// Insiemi di parametri noti a compile time. Con i coeff modulus di default di SEAL (BFVDefault) un
+// ciphertext fresco ha due polinomi di Degree coefficienti per ognuno dei CtModuli moduli del livello
+// dati (tutti quelli di BFVDefault tranne lo special prime, che con un solo modulo non c'è): la sua
+// dimensione serializzata, il numero di frammenti e la larghezza della bitmap del riassemblaggio sono
+// quindi costanti. Il codice specializzato si sceglie all'avvio (dispatch_param_set) dal grado della
+// configurazione, e si usa solo se anche il numero di moduli corrisponde
+template <size_t Degree, size_t CtModuli, size_t ChunkSize = CHUNK_SIZE>
+struct ParamSet {
+    static constexpr bool fixed = true;
+    static constexpr size_t degree = Degree;
+    static constexpr size_t ct_moduli = CtModuli;
+    static constexpr size_t chunk_size = ChunkSize;
+
+    // Ciphertext non compresso: coefficienti più un margine per gli header della serializzazione SEAL
+    static constexpr size_t ciphertext_bytes = 2 * Degree * CtModuli * sizeof(uint64_t) + 256;
+    // Slot-map più lunga possibile: una sorgente per slot
+    static constexpr size_t slot_map_bytes = sizeof(SlotMapHeader) + Degree * sizeof(SlotMapEntry);
+    static constexpr size_t max_message_bytes = ciphertext_bytes + slot_map_bytes;
+    static constexpr size_t max_chunks = (max_message_bytes + ChunkSize - 1) / ChunkSize;
+    static constexpr size_t bitmap_words = (max_chunks + 63) / 64;
+
+    // Oltre 65535 frammenti si usa l'header esteso (TelemetryHeaderWide)
+    static_assert(max_message_bytes <= UINT32_MAX, "ciphertext_total_size dell'header è a 32 bit");
+};
+
+using ParamSet2048 = ParamSet<2048, 1>;   // BFVDefault(2048): un modulo da 54 bit
+using ParamSet4096 = ParamSet<4096, 2>;   // BFVDefault(4096): 36 + 36 bit (+ special prime da 37)
+using ParamSet8192 = ParamSet<8192, 4>;   // BFVDefault(8192): 43 + 43 + 44 + 44 bit (+ special prime da 44)
+using ParamSet16384 = ParamSet<16384, 8>; // BFVDefault(16384): 8 moduli da 48 bit (+ special prime da 48)
+
+// Parametri noti solo a runtime (gradi diversi o coeff modulus da seal.parms): stessi nomi, nessun limite
+struct DynamicParamSet {
+    static constexpr bool fixed = false;
+    static constexpr size_t chunk_size = CHUNK_SIZE;
+};
+
+// Chiama f con l'insieme di parametri del grado indicato (un oggetto vuoto, serve solo il tipo) o con
+// DynamicParamSet per gli altri gradi. Come add_mod_poly in he_context.cpp: le istanze sono solo queste
+template <class F>
+decltype(auto) dispatch_param_set(size_t degree, F &&f)
+{
+    switch (degree) {
+    case 2048: return f(ParamSet2048{});
+    case 4096: return f(ParamSet4096{});
+    case 8192: return f(ParamSet8192{});
+    case 16384: return f(ParamSet16384{});
+    default: return f(DynamicParamSet{});
+    }
+}
+
+#endif
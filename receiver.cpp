@@ -1,25 +1,56 @@
 // Receiver, da eseguire in nsp1
 
+#include <atomic>
+#include <csignal>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
 #include <sstream>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include "seal/seal.h"
+#include "decrypt_pipeline.h"
 #include "packet_assembler.h"
-#include "config.h"
+#include "runtime_config.h"
+#include "seal_params.h"
 
 using namespace seal;
 
-int main() {
-    // Setup SEAL con parametri da config.h
-    EncryptionParameters parms(scheme_type::bfv);
-    parms.set_poly_modulus_degree(POLY_MODULUS_DEGREE);
-    parms.set_coeff_modulus(CoeffModulus::BFVDefault(POLY_MODULUS_DEGREE));
-    parms.set_plain_modulus(PLAIN_MODULUS);
-    SEALContext context(parms);
+static std::atomic_bool exit_request(false);
+
+static void handle_exit_signal(int sig) {
+    (void)sig;
+    exit_request.store(true);
+}
+
+int main(int argc, char* argv[]) {
+    // Parametri da config.h, modificabili con --config <file> o --<parametro> <valore>
+    RuntimeConfig& cfg = runtime_config();
+    if (!parse_config_args(cfg, argc, argv))
+        return 1;
+
+    // Uscita dei valori decifrati: --output <file>, "-" (stdout, default) o "none".
+    // --results-log <file>: log binario dei valori (vedi results_log.h), si aggiunge all'uscita testuale
+    std::string output = "-";
+    std::string results_log_path;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--results-log") == 0 && i + 1 < argc) {
+            results_log_path = argv[++i];
+        } else {
+            std::cerr << "Argomenti non validi: [--output <file>|-|none] [--results-log <file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Setup SEAL (parametri da seal.parms scritto da keygen)
+    if (!init_seal_context(cfg))
+        return 1;
+    const SEALContext &context = *seal_context();
 
     // Carica secret key da file
     SecretKey secret_key;
@@ -32,10 +63,18 @@ int main() {
     sk_file.close();
     std::cout << "Secret key caricata" << std::endl;
 
-    Decryptor decryptor(context, secret_key);
-    BatchEncoder encoder(context);
-    
-    PacketAssembler assembler;
+    // La decifratura avviene nei worker: il thread RX riassembla soltanto
+    OutputSink sink;
+    if (!sink.open(output))
+        return 1;
+    ResultsLogWriter results_log;
+    if (!results_log_path.empty() && !results_log.open(results_log_path, cfg.poly_modulus_degree, cfg.plain_modulus))
+        return 1;
+    DecryptPipeline pipeline(context, secret_key, sink, cfg.decrypt_workers, cfg.decrypt_queue_size,
+                             results_log_path.empty() ? nullptr : &results_log);
+    std::cout << "Decifratura su " << cfg.decrypt_workers << " thread" << std::endl;
+
+    PacketAssembler assembler(cfg.poly_modulus_degree, ciphertext_moduli(context));
 
     // Socket UDP
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -47,10 +86,10 @@ int main() {
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(RX_PORT);
+    addr.sin_port = htons(cfg.rx_port);
     
     if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        std::cerr << "Errore bind porta " << RX_PORT << std::endl;
+        std::cerr << "Errore bind porta " << cfg.rx_port << std::endl;
         close(sock);
         return 1;
     }
@@ -61,11 +100,17 @@ int main() {
         std::cerr << "Warning: impossibile aumentare buffer ricezione" << std::endl;
     }
     
-    std::cout << "In ascolto su porta " << RX_PORT << std::endl;
+    // Timeout di ricezione per controllare exit_request anche senza traffico
+    timeval rx_timeout{0, 200000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &rx_timeout, sizeof(rx_timeout));
+    signal(SIGINT, handle_exit_signal);
+    signal(SIGTERM, handle_exit_signal);
+
+    std::cout << "In ascolto su porta " << cfg.rx_port << std::endl;
     
-    std::vector<char> buffer(sizeof(TelemetryHeader) + CHUNK_SIZE);
+    std::vector<char> buffer(sizeof(TelemetryHeader) + sizeof(TelemetryHeaderWide) + CHUNK_SIZE);
 
-    while (true) {
+    while (!exit_request.load()) {
         sockaddr_in sender;
         socklen_t sender_len = sizeof(sender);
         
@@ -77,26 +122,23 @@ int main() {
 
             auto result = assembler.process_packet(buffer.data(), n);
             
-            if (result.complete) {
-                std::cout << "Messaggio " << result.message_id << " completo (" 
-                     << result.data.size() << " bytes)" << std::endl;
-                
-                // Decripta 
-                Ciphertext ct;
-                ct.load(context, reinterpret_cast<const seal::seal_byte*>(result.data.data()), result.data.size());
-
-                Plaintext ptx;
-                decryptor.decrypt(ct, ptx);
-
-                std::vector<uint64_t> valori;
-                encoder.decode(ptx, valori);
-
-                std::cout << "Valore decriptato: " << valori[0]
-                     << ", atteso: 13291" << std::endl;
-            }
+            // Il messaggio passa ai worker senza copie; se sono tutti occupati viene scartato
+            // invece di fermare la ricezione (che perderebbe frammenti di tutti i messaggi)
+            if (result.complete)
+                pipeline.submit(result.message_id, result.data);
         }
     }
     
     close(sock);
+    pipeline.stop();
+    sink.close();
+    results_log.close();
+    std::cout << "Messaggi decifrati: " << pipeline.get_decrypted()
+              << ", scartati con i worker occupati: " << pipeline.get_dropped() << std::endl;
+    if (sink.get_dropped_bytes() > 0)
+        std::cout << "Output scartato (scrittura troppo lenta): " << sink.get_dropped_bytes() << " byte" << std::endl;
+    if (!results_log_path.empty())
+        std::cout << "Record nel log dei risultati: " << results_log.get_written()
+                  << ", scartati (scrittura troppo lenta): " << results_log.get_dropped() << std::endl;
     return 0;
-}
\ No newline at end of file
+}
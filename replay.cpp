@@ -0,0 +1,406 @@
+// Replay deterministico di frammenti di telemetria per misurare il forwarder senza DPU.
+//
+//   replay synth <file.pcap> [n_messaggi] [--reorder p] [--loss p] [--dup p] [--symmetric] [--seed s]
+//       Genera un pcap con i frammenti di n_messaggi messaggi cifrati come li manda il sender
+//       (slot-map + ciphertext, porte base_port..base_port+n_ports-1). Con probabilità p i frammenti
+//       di un messaggio vengono mescolati (--reorder), un frammento viene perso (--loss) o duplicato (--dup).
+//
+//   replay run <file.pcap> [--rate pps] [--loops n] [--burst n]
+//       Passa i frame al datapath del forwarder (lo stesso codice di rss_forwarding) in questo processo,
+//       alla massima velocità o a pps pacchetti al secondo, e stampa msg/s, pps e tempi per fase.
+//
+//   replay check-cut-through [n_messaggi] [--seed s]
+//       Verifica che il cut-through (StreamPatcher) produca gli stessi byte del percorso con riassemblaggio
+//       e add_plain_number_fast, con frammenti mescolati e duplicati, header normale ed esteso, ciphertext
+//       normali e seeded. Per i messaggi più grandi: --poly-modulus-degree 16384 (~2100 frammenti).
+//
+// Le opzioni di runtime_config (--config, --poly-modulus-degree, --agg-window-msgs, ...) valgono per
+// entrambi i comandi. Lo stesso pcap si può dare al backend DPDK di sw_forwarding, per misurare anche
+// il driver: sw_forwarding dpdk -l 0 --vdev=net_pcap0,rx_pcap=f.pcap,infinite_rx=1 --vdev=net_null1
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include "seal/seal.h"
+
+#include "forwarder.h"
+#include "message.h"
+#include "packet_io_pcap.h"
+#include "runtime_config.h"
+#include "seal_params.h"
+
+using namespace seal;
+
+// Frame Ethernet/IPv4/UDP di un frammento, da nsp1 (192.168.28.11) a nsp0 (192.168.28.10)
+static std::vector<uint8_t> build_frame(const FragmentInfo &hdr, const char *chunk, uint16_t dst_port)
+{
+    const uint8_t src_mac[ETH_ALEN] = {0x02, 0, 0, 0, 0, 0x11};
+    const uint8_t dst_mac[ETH_ALEN] = {0x02, 0, 0, 0, 0, 0x10};
+    uint16_t payload_size = fragment_header_size(hdr.total_chunks) + hdr.chunk_size;
+
+    std::vector<uint8_t> frame(sizeof(struct ether_header) + sizeof(struct iphdr) + sizeof(struct udphdr) + payload_size);
+    struct ether_header *eth = (struct ether_header *)frame.data();
+    memcpy(eth->ether_shost, src_mac, ETH_ALEN);
+    memcpy(eth->ether_dhost, dst_mac, ETH_ALEN);
+    eth->ether_type = htons(ETHERTYPE_IP);
+
+    struct iphdr *ip = (struct iphdr *)(eth + 1);
+    memset(ip, 0, sizeof(*ip));
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons(sizeof(struct iphdr) + sizeof(struct udphdr) + payload_size);
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->saddr = inet_addr("192.168.28.11");
+    ip->daddr = inet_addr("192.168.28.10");
+    ip->check = ipv4_checksum(ip);
+
+    struct udphdr *udp = (struct udphdr *)(ip + 1);
+    udp->source = htons(dst_port);   // Come il sender: un thread (e una porta) per porta di destinazione
+    udp->dest = htons(dst_port);
+    udp->len = htons(sizeof(struct udphdr) + payload_size);
+    udp->check = 0;
+
+    char *payload = (char *)(udp + 1);
+    size_t hdr_size = write_fragment_header(payload, hdr.message_id, hdr.total_chunks, hdr.chunk_index,
+                                            hdr.total_size, hdr.chunk_size);
+    memcpy(payload + hdr_size, chunk, hdr.chunk_size);
+    return frame;
+}
+
+// Payload di un messaggio come in sender.cpp (encrypt_payload): slot-map vuota + ciphertext non
+// compresso, seeded con --symmetric. Chiavi generate qui: al forwarder non servono
+static std::vector<char> make_payload(bool symmetric)
+{
+    // Stesso contesto del forwarder che elaborerà i messaggi
+    const SEALContext &context = *seal_context();
+
+    KeyGenerator keygen(context);
+    BatchEncoder encoder(context);
+    std::vector<uint64_t> values(encoder.slot_count(), 42);
+    Plaintext ptx;
+    encoder.encode(values, ptx);
+
+    std::vector<char> payload(sizeof(SlotMapHeader), 0);
+    size_t map_size = payload.size();
+    if (symmetric) {
+        Encryptor encryptor(context, keygen.secret_key());
+        Serializable<Ciphertext> sct = encryptor.encrypt_symmetric(ptx);
+        payload.resize(map_size + sct.save_size(compr_mode_type::none));
+        auto written = sct.save((seal_byte *)payload.data() + map_size, payload.size() - map_size, compr_mode_type::none);
+        payload.resize(map_size + written);
+    } else {
+        PublicKey public_key;
+        keygen.create_public_key(public_key);
+        Encryptor encryptor(context, public_key);
+        Ciphertext ct;
+        encryptor.encrypt(ptx, ct);
+        payload.resize(map_size + ct.save_size(compr_mode_type::none));
+        auto written = ct.save((seal_byte *)payload.data() + map_size, payload.size() - map_size, compr_mode_type::none);
+        payload.resize(map_size + written);
+    }
+    return payload;
+}
+
+static int synth(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Argomenti non validi: synth <file.pcap> [n_messaggi] [--reorder p] [--loss p] [--dup p] [--symmetric] [--seed s]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[2];
+    uint32_t n_messages = 10000;
+    double reorder = 0, loss = 0, dup = 0;
+    bool symmetric = false;
+    uint32_t seed = 1;
+    for (int i = 3; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--symmetric")
+            symmetric = true;
+        else if (opt == "--reorder" && i + 1 < argc)
+            reorder = atof(argv[++i]);
+        else if (opt == "--loss" && i + 1 < argc)
+            loss = atof(argv[++i]);
+        else if (opt == "--dup" && i + 1 < argc)
+            dup = atof(argv[++i]);
+        else if (opt == "--seed" && i + 1 < argc)
+            seed = atoi(argv[++i]);
+        else if (opt[0] != '-')
+            n_messages = atoi(argv[i]);
+        else {
+            std::cerr << "Opzione sconosciuta: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    // Lo stesso ciphertext per tutti i messaggi: il forwarder non guarda il contenuto
+    std::vector<char> payload = make_payload(symmetric);
+    uint32_t total_size = payload.size();
+    uint32_t total_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    const RuntimeConfig &cfg = runtime_config();
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint32_t> order(total_chunks);
+    uint64_t lost = 0, duplicated = 0, reordered = 0;
+
+    for (uint32_t id = 0; id < n_messages; id++) {
+        for (uint32_t i = 0; i < total_chunks; i++)
+            order[i] = i;
+        if (coin(rng) < reorder) {
+            std::shuffle(order.begin(), order.end(), rng);
+            reordered++;
+        }
+
+        uint16_t dst_port = cfg.base_port + id % cfg.n_ports;
+        for (uint32_t idx : order) {
+            FragmentInfo hdr;
+            hdr.message_id = id;
+            hdr.total_chunks = total_chunks;
+            hdr.chunk_index = idx;
+            hdr.total_size = total_size;
+            hdr.chunk_size = std::min<uint32_t>(CHUNK_SIZE, total_size - idx * CHUNK_SIZE);
+
+            if (coin(rng) < loss) {
+                lost++;
+                continue;
+            }
+            frames.push_back(build_frame(hdr, payload.data() + idx * CHUNK_SIZE, dst_port));
+            if (coin(rng) < dup) {
+                frames.push_back(frames.back());
+                duplicated++;
+            }
+        }
+    }
+
+    if (!write_pcap(path, frames))
+        return 1;
+    std::cout << path << ": " << n_messages << " messaggi da " << total_chunks << " frammenti ("
+              << total_size << " byte), " << frames.size() << " frame; " << reordered << " messaggi mescolati, "
+              << lost << " frammenti persi, " << duplicated << " duplicati" << std::endl;
+    return 0;
+}
+
+// Frammenti di un payload in ordine casuale, con un duplicato ogni 16 frammenti circa. Con wide l'header
+// è sempre quello esteso (TelemetryHeaderWide), che il sender usa solo oltre 65535 frammenti
+static std::vector<std::vector<char>> shuffled_fragments(const std::vector<char> &payload, uint32_t message_id,
+                                                         bool wide, std::mt19937 &rng)
+{
+    uint32_t total_size = payload.size();
+    uint32_t total_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::vector<char>> fragments(total_chunks);
+    for (uint32_t i = 0; i < total_chunks; i++) {
+        uint16_t chunk_size = std::min<uint32_t>(CHUNK_SIZE, total_size - i * CHUNK_SIZE);
+        std::vector<char> &frag = fragments[i];
+        frag.resize(sizeof(TelemetryHeader) + sizeof(TelemetryHeaderWide) + chunk_size);
+        size_t hdr_size;
+        if (wide) {
+            TelemetryHeader hdr{message_id, TELEMETRY_WIDE, 0, total_size, chunk_size};
+            TelemetryHeaderWide ext{total_chunks, i};
+            memcpy(frag.data(), &hdr, sizeof(hdr));
+            memcpy(frag.data() + sizeof(hdr), &ext, sizeof(ext));
+            hdr_size = sizeof(hdr) + sizeof(ext);
+        } else {
+            hdr_size = write_fragment_header(frag.data(), message_id, total_chunks, i, total_size, chunk_size);
+        }
+        memcpy(frag.data() + hdr_size, payload.data() + i * CHUNK_SIZE, chunk_size);
+        frag.resize(hdr_size + chunk_size);
+    }
+    for (uint32_t i = 0; i < total_chunks / 16; i++)
+        fragments.push_back(fragments[rng() % total_chunks]);
+    std::shuffle(fragments.begin(), fragments.end(), rng);
+    return fragments;
+}
+
+// Un messaggio nei due percorsi del forwarder: ritorna true se i risultati coincidono
+static bool cut_through_matches(HEContext &he, StreamPatcher &patcher, const std::vector<char> &payload,
+                                uint32_t message_id, bool wide, std::mt19937 &rng)
+{
+    const SEALContext &context = *he.context;
+    const size_t map_size = sizeof(SlotMapHeader);  // Slot-map vuota di make_payload
+
+    // Cut-through: frammenti inoltrati subito o rilasciati più tardi, riassemblati come fa il receiver
+    PacketAssembler assembler(0, ciphertext_moduli(context));
+    PacketAssembler::AssemblyResult streamed{false, 0, {}};
+    bool complete = false;
+    for (auto &frag : shuffled_fragments(payload, message_id, wide, rng)) {
+        bool done;
+        if (patcher.process(frag.data(), frag.size(), done) == StreamPatcher::Action::Forward)
+            patcher.released().push_back(frag);
+        complete |= done;
+        for (auto &out : patcher.released()) {
+            auto result = assembler.process_packet(out.data(), out.size());
+            if (result.complete)
+                streamed = std::move(result);
+        }
+        patcher.released().clear();
+    }
+    if (!complete || !streamed.complete) {
+        std::cerr << "Messaggio " << message_id << ": cut-through incompleto" << std::endl;
+        return false;
+    }
+
+    // Percorso con riassemblaggio (come process_message): load, somma con la costante, save
+    Ciphertext ct;
+    ct.load(context, (const seal_byte *)payload.data() + map_size, payload.size() - map_size);
+    he.add_plain_number_fast(ct, 13291);
+    std::vector<char> expected(map_size + ct.save_size(compr_mode_type::none));
+    memcpy(expected.data(), payload.data(), map_size);
+    expected.resize(map_size + ct.save((seal_byte *)expected.data() + map_size, expected.size() - map_size,
+                                       compr_mode_type::none));
+
+    // I ciphertext seeded restano seeded in cut-through: si confrontano dopo averli espansi
+    std::vector<char> got = std::move(streamed.data);
+    if (got.size() != expected.size()) {
+        Ciphertext loaded;
+        loaded.load(context, (const seal_byte *)got.data() + map_size, got.size() - map_size);
+        got.resize(map_size + loaded.save_size(compr_mode_type::none));
+        got.resize(map_size + loaded.save((seal_byte *)got.data() + map_size, got.size() - map_size,
+                                          compr_mode_type::none));
+    }
+    if (got != expected) {
+        std::cerr << "Messaggio " << message_id << " (header " << (wide ? "esteso" : "normale")
+                  << "): il cut-through differisce dal riassemblaggio" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static int check_cut_through(int argc, char *argv[])
+{
+    uint32_t n_messages = 4;
+    uint32_t seed = 1;
+    for (int i = 2; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--seed" && i + 1 < argc)
+            seed = atoi(argv[++i]);
+        else if (opt[0] != '-')
+            n_messages = atoi(argv[i]);
+        else {
+            std::cerr << "Opzione sconosciuta: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    HEContext he;
+    StreamPatcher patcher;
+    if (!patcher.init(he, 13291)) {
+        std::cerr << "Parametri non adatti al cut-through" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    uint32_t checked = 0, failed = 0;
+    for (bool symmetric : {false, true}) {
+        std::vector<char> payload = make_payload(symmetric);
+        for (uint32_t i = 0; i < n_messages; i++) {
+            bool wide = (i % 2) == 1;
+            failed += !cut_through_matches(he, patcher, payload, checked++, wide, rng);
+        }
+    }
+
+    std::cout << "Cut-through, grado " << runtime_config().poly_modulus_degree << ": " << (checked - failed) << "/"
+              << checked << " messaggi uguali al riassemblaggio" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+static int run(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Argomenti non validi: run <file.pcap> [--rate pps] [--loops n] [--burst n]" << std::endl;
+        return 1;
+    }
+    PcapReplayIO io;
+    if (!io.open(argv[2]))
+        return 1;
+
+    uint16_t burst = runtime_config().burst_size;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "--rate")
+            io.set_rate(strtoull(argv[i + 1], nullptr, 10));
+        else if (opt == "--loops")
+            io.set_loops(atoi(argv[i + 1]));
+        else if (opt == "--burst") {
+            int value = atoi(argv[i + 1]);
+            if (value <= 0) {
+                std::cerr << "Il burst deve essere > 0" << std::endl;
+                return 1;
+            }
+            burst = std::min<uint32_t>(value, PACKET_IO_MAX_BURST);
+        } else {
+            std::cerr << "Opzione sconosciuta: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    const RuntimeConfig &cfg = runtime_config();
+    AggregationTable *agg_table = nullptr;
+    if (cfg.agg_window_msgs > 0)
+        agg_table = new AggregationTable(cfg.agg_window_msgs, std::chrono::milliseconds(cfg.agg_window_ms));
+
+    set_stats_lcore_count(1);
+    double seconds;
+    {
+        // Stesso datapath di un lcore della DPU: ingress = porta 0 (il file), egress = porta 1
+        Forwarder fwd(io, agg_table, nullptr, 0);
+        std::cout << "Replay di " << io.frame_count() << " frame con burst " << burst << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        while (!io.done()) {
+            fwd.poll(0, 0, 1, 0, burst);
+            fwd.poll_scheduler();
+            fwd.poll_timers(1, 0);
+        }
+        // Messaggi rimasti nelle code dei tenant, poi le finestre di aggregazione ancora aperte
+        while (fwd.poll_scheduler() > 0)
+            fwd.poll_timers(1, 0);
+        fwd.flush_aggregates(1, 0);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    delete agg_table;
+
+    StatsSnapshot stats = read_lcore_stats(0);
+    uint64_t messages = stats[STAT_COMPLETED_MESSAGES];
+    std::cout << "Tempo: " << seconds << " s" << std::endl;
+    std::cout << "RX: " << stats[STAT_RX_PKTS] << " pacchetti, " << (stats[STAT_RX_PKTS] / seconds) << " pps, "
+              << (stats[STAT_RX_BYTES] * 8 / seconds / 1e6) << " Mbps" << std::endl;
+    std::cout << "TX: " << io.get_tx_pkts() << " pacchetti, " << (io.get_tx_pkts() / seconds) << " pps" << std::endl;
+    std::cout << "Messaggi completati: " << messages << ", " << (messages / seconds) << " msg/s" << std::endl;
+    if (stats[STAT_RX_PKTS] > 0)
+        std::cout << "Tempo per pacchetto: " << (seconds * 1e9 / stats[STAT_RX_PKTS]) << " ns" << std::endl;
+    if (messages > 0)
+        std::cout << "Tempo per messaggio: " << (seconds * 1e6 / messages)
+                  << " µs (HE qui sotto, il resto è ricezione, riassemblaggio e frammentazione)" << std::endl;
+    print_he_benchmark();
+    print_stats_summary();
+    print_tenant_stats();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!parse_config_args(runtime_config(), argc, argv) || !init_seal_context(runtime_config()))
+        return 1;
+
+    std::string cmd = (argc > 1) ? argv[1] : "";
+    if (cmd == "synth")
+        return synth(argc, argv);
+    if (cmd == "run")
+        return run(argc, argv);
+    if (cmd == "check-cut-through")
+        return check_cut_through(argc, argv);
+
+    std::cerr << "Argomenti non validi: <synth|run> <file.pcap> ... | check-cut-through [n_messaggi]" << std::endl;
+    return 1;
+}
@@ -0,0 +1,71 @@
+// Lettura del log binario dei risultati del receiver (results_log.h), tramite mmap.
+//
+//   results_dump <file.log> [--id message_id] [--since ns] [--count n] [--slots n]
+//       Stampa i record a partire dal messaggio message_id (cercato con gli indici dei segmenti) o dal
+//       primo con timestamp >= ns (CLOCK_REALTIME), al massimo n record (default tutti) e per ognuno
+//       le sorgenti della slot-map e i primi --slots valori (default 4)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "results_log.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " <file.log> [--id message_id] [--since ns] [--count n] [--slots n]" << std::endl;
+        return 1;
+    }
+
+    ResultsLogReader log;
+    if (!log.open(argv[1]))
+        return 1;
+
+    uint64_t first = 0;
+    uint64_t count = log.count();
+    uint32_t n_slots = 4;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--id") == 0 && i + 1 < argc) {
+            int64_t index = log.find_message(strtoul(argv[++i], nullptr, 10));
+            if (index < 0) {
+                std::cerr << "Messaggio " << argv[i] << " non presente" << std::endl;
+                return 1;
+            }
+            first = index;
+        } else if (strcmp(argv[i], "--since") == 0 && i + 1 < argc) {
+            first = log.seek_time(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc) {
+            n_slots = strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Argomento non valido: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    const ResultsLogHeader &hdr = log.header();
+    std::cout << log.count() << " record, " << hdr.slots_per_record << " slot per record, plain modulus "
+              << hdr.plain_modulus << std::endl;
+    if (n_slots > hdr.slots_per_record)
+        n_slots = hdr.slots_per_record;
+
+    for (uint64_t i = first; i < log.count() && i - first < count; i++) {
+        const ResultRecord &rec = log.record(i);
+        const uint64_t *values = log.values(rec);
+        std::cout << rec.timestamp_ns << " messaggio " << rec.message_id;
+        if (rec.flags & RESULT_SOURCES_TRUNCATED)
+            std::cout << " (slot-map troncata)";
+        for (uint16_t s = 0; s < rec.n_sources; s++) {
+            const SlotMapEntry &entry = rec.sources[s];
+            std::cout << " [sorgente " << entry.source_id << ": slot " << entry.first_slot << "+" << entry.n_slots << "]";
+        }
+        std::cout << " valori:";
+        for (uint32_t s = 0; s < n_slots; s++)
+            std::cout << " " << values[s];
+        std::cout << std::endl;
+    }
+    return 0;
+}
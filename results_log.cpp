@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "results_log.h"
+
+// Buffer di scrittura per log: uno in riempimento e gli altri in coda per la write. Se sono tutti
+// occupati il disco è indietro di (RESULTS_LOG_BUFFERS - 1) * write_buffer_size byte e i record si scartano
+constexpr size_t RESULTS_LOG_BUFFERS = 4;
+constexpr uint32_t RESULTS_LOG_VERSION = 1;
+
+static uint64_t realtime_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static size_t segment_stride(uint32_t record_size)
+{
+    return (size_t)RESULTS_LOG_SEGMENT_RECORDS * record_size + sizeof(ResultsIndexBlock);
+}
+
+static void reset_index(ResultsIndexBlock &index, uint64_t segment)
+{
+    index = ResultsIndexBlock{};
+    index.magic = RESULTS_INDEX_MAGIC;
+    index.segment = segment;
+    index.min_message_id = UINT32_MAX;
+    index.min_timestamp_ns = UINT64_MAX;
+}
+
+static void update_index(ResultsIndexBlock &index, uint32_t message_id, uint64_t timestamp_ns)
+{
+    index.min_message_id = std::min(index.min_message_id, message_id);
+    index.max_message_id = std::max(index.max_message_id, message_id);
+    index.min_timestamp_ns = std::min(index.min_timestamp_ns, timestamp_ns);
+    index.max_timestamp_ns = std::max(index.max_timestamp_ns, timestamp_ns);
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+ResultsLogWriter::~ResultsLogWriter()
+{
+    close();
+}
+
+bool ResultsLogWriter::open(const std::string &path, uint32_t slots, uint64_t plain_modulus, size_t write_buffer_size)
+{
+    slots_per_record = slots;
+    record_size = sizeof(ResultRecord) + slots * sizeof(uint64_t);
+    size_t stride = segment_stride(record_size);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Impossibile aprire " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size == 0) {
+        // File nuovo: header in un blocco intero, i record partono allineati alla pagina
+        std::vector<uint8_t> block(RESULTS_LOG_HEADER_SIZE, 0);
+        ResultsLogHeader hdr{};
+        memcpy(hdr.magic, RESULTS_LOG_MAGIC, sizeof(hdr.magic));
+        hdr.version = RESULTS_LOG_VERSION;
+        hdr.record_size = record_size;
+        hdr.slots_per_record = slots_per_record;
+        hdr.segment_records = RESULTS_LOG_SEGMENT_RECORDS;
+        hdr.plain_modulus = plain_modulus;
+        hdr.created_ns = realtime_ns();
+        memcpy(block.data(), &hdr, sizeof(hdr));
+        if (!write_all(fd, block.data(), block.size())) {
+            std::cerr << "Errore di scrittura su " << path << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        segment = 0;
+        segment_count = 0;
+        reset_index(index, 0);
+    } else {
+        // File esistente: si continua solo con lo stesso formato
+        ResultsLogHeader hdr{};
+        if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) || memcmp(hdr.magic, RESULTS_LOG_MAGIC, sizeof(hdr.magic)) != 0
+            || hdr.version != RESULTS_LOG_VERSION || hdr.record_size != record_size
+            || hdr.segment_records != RESULTS_LOG_SEGMENT_RECORDS) {
+            std::cerr << path << ": non è un log dei risultati con " << slots_per_record << " slot per record" << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+
+        // Un record scritto a metà (interruzione durante una write) viene eliminato
+        size_t data_size = st.st_size - RESULTS_LOG_HEADER_SIZE;
+        segment = data_size / stride;
+        segment_count = std::min<size_t>(data_size % stride / record_size, RESULTS_LOG_SEGMENT_RECORDS);
+        off_t end = RESULTS_LOG_HEADER_SIZE + segment * stride + (off_t)segment_count * record_size;
+        if (ftruncate(fd, end) < 0) {
+            std::cerr << "Errore su " << path << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        lseek(fd, end, SEEK_SET);
+
+        // L'indice del segmento incompleto si ricostruisce dai suoi record
+        reset_index(index, segment);
+        for (uint32_t i = 0; i < segment_count; i++) {
+            ResultRecord rec;
+            if (pread(fd, &rec, sizeof(rec), RESULTS_LOG_HEADER_SIZE + segment * stride + (off_t)i * record_size)
+                != (ssize_t)sizeof(rec))
+                break;
+            update_index(index, rec.message_id, rec.timestamp_ns);
+        }
+        // Segmento pieno ma interrotto prima dell'indice
+        if (segment_count == RESULTS_LOG_SEGMENT_RECORDS) {
+            write_all(fd, (const uint8_t *)&index, sizeof(index));
+            reset_index(index, ++segment);
+            segment_count = 0;
+        }
+    }
+
+    // Buffer allineati alla pagina: ogni write parte da un indirizzo allineato e copre
+    // write_buffer_size byte (salvo gli svuotamenti periodici)
+    buffer_capacity = std::max<size_t>(write_buffer_size, record_size + sizeof(ResultsIndexBlock));
+    for (size_t i = 0; i < RESULTS_LOG_BUFFERS; i++) {
+        AlignedBuffer buf;
+        if (posix_memalign((void **)&buf.data, 4096, buffer_capacity) != 0) {
+            std::cerr << "Impossibile allocare i buffer del log dei risultati" << std::endl;
+            close();
+            return false;
+        }
+        spare.push_back(buf);
+    }
+    filling = spare.back();
+    spare.pop_back();
+    record.assign(record_size, 0);
+
+    written.store(0);
+    dropped.store(0);
+    stopping = false;
+    writer = std::thread(&ResultsLogWriter::writer_loop, this);
+    return true;
+}
+
+void ResultsLogWriter::close()
+{
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        writer.join();
+    }
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+        fd = -1;
+    }
+    free(filling.data);
+    filling = AlignedBuffer{};
+    for (AlignedBuffer &buf : spare)
+        free(buf.data);
+    for (AlignedBuffer &buf : full)
+        free(buf.data);
+    spare.clear();
+    full.clear();
+}
+
+void ResultsLogWriter::append_bytes(const void *bytes, size_t n)
+{
+    const uint8_t *src = (const uint8_t *)bytes;
+    while (n > 0) {
+        if (filling.size == buffer_capacity) {
+            full.push_back(filling);
+            filling = spare.back();
+            spare.pop_back();
+            filling.size = 0;
+        }
+        size_t chunk = std::min(n, buffer_capacity - filling.size);
+        memcpy(filling.data + filling.size, src, chunk);
+        filling.size += chunk;
+        src += chunk;
+        n -= chunk;
+    }
+}
+
+void ResultsLogWriter::append(uint32_t message_id, const std::vector<SlotMapEntry> &slot_map, const std::vector<uint64_t> &values)
+{
+    if (fd < 0)
+        return;
+
+    uint64_t timestamp_ns = realtime_ns();
+    size_t n_values = std::min<size_t>(values.size(), slots_per_record);
+    size_t n_sources = std::min(slot_map.size(), RESULTS_LOG_MAX_SOURCES);
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        // Il record (e l'eventuale indice) deve entrare per intero nello spazio libero
+        size_t need = record_size + (segment_count + 1 == RESULTS_LOG_SEGMENT_RECORDS ? sizeof(ResultsIndexBlock) : 0);
+        if (buffer_capacity - filling.size + spare.size() * buffer_capacity < need) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ResultRecord *rec = (ResultRecord *)record.data();
+        memset(rec, 0, sizeof(ResultRecord));
+        rec->timestamp_ns = timestamp_ns;
+        rec->message_id = message_id;
+        rec->n_sources = n_sources;
+        if (n_sources < slot_map.size())
+            rec->flags |= RESULT_SOURCES_TRUNCATED;
+        if (n_values < values.size())
+            rec->flags |= RESULT_SLOTS_TRUNCATED;
+        if (n_sources > 0)
+            memcpy(rec->sources, slot_map.data(), n_sources * sizeof(SlotMapEntry));
+        uint64_t *dst = (uint64_t *)(rec + 1);
+        if (n_values > 0)
+            memcpy(dst, values.data(), n_values * sizeof(uint64_t));
+        memset(dst + n_values, 0, (slots_per_record - n_values) * sizeof(uint64_t));
+        append_bytes(record.data(), record_size);
+
+        update_index(index, message_id, timestamp_ns);
+        if (++segment_count == RESULTS_LOG_SEGMENT_RECORDS) {
+            append_bytes(&index, sizeof(index));
+            reset_index(index, ++segment);
+            segment_count = 0;
+        }
+        wake = !full.empty();
+    }
+    written.fetch_add(1, std::memory_order_relaxed);
+    if (wake)
+        cv.notify_one();
+}
+
+void ResultsLogWriter::writer_loop()
+{
+    std::vector<AlignedBuffer> batch;
+    bool error = false;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        // Scrittura quando c'è un buffer pieno, altrimenti svuotamento ogni 100 ms perché i lettori
+        // vedano i record recenti anche con poco traffico
+        cv.wait_for(lock, std::chrono::milliseconds(100), [this] { return stopping || !full.empty(); });
+        if (full.empty() && filling.size > 0 && !spare.empty()) {
+            full.push_back(filling);
+            filling = spare.back();
+            spare.pop_back();
+            filling.size = 0;
+        }
+        batch.swap(full);
+        bool stop = stopping;
+        lock.unlock();
+
+        for (AlignedBuffer &buf : batch) {
+            if (!error && !write_all(fd, buf.data, buf.size)) {
+                std::cerr << "Errore di scrittura del log dei risultati: " << strerror(errno) << std::endl;
+                error = true;
+            }
+            buf.size = 0;
+        }
+
+        lock.lock();
+        spare.insert(spare.end(), batch.begin(), batch.end());
+        batch.clear();
+        if (stop && full.empty()) {
+            // Ultimo blocco parziale
+            if (!error && filling.size > 0)
+                write_all(fd, filling.data, filling.size);
+            filling.size = 0;
+            break;
+        }
+    }
+}
+
+ResultsLogReader::~ResultsLogReader()
+{
+    close();
+}
+
+bool ResultsLogReader::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Impossibile aprire " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    if ((size_t)st.st_size < RESULTS_LOG_HEADER_SIZE) {
+        std::cerr << path << ": file troppo corto" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "mmap di " << path << " fallita: " << strerror(errno) << std::endl;
+        return false;
+    }
+    base = (const uint8_t *)map;
+    size = st.st_size;
+
+    const ResultsLogHeader &hdr = header();
+    if (memcmp(hdr.magic, RESULTS_LOG_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != RESULTS_LOG_VERSION
+        || hdr.segment_records != RESULTS_LOG_SEGMENT_RECORDS || hdr.record_size < sizeof(ResultRecord)) {
+        std::cerr << path << ": non è un log dei risultati" << std::endl;
+        close();
+        return false;
+    }
+
+    segment_stride = ::segment_stride(hdr.record_size);
+    size_t data_size = size - RESULTS_LOG_HEADER_SIZE;
+    size_t tail = data_size % segment_stride;
+    n_records = (data_size / segment_stride) * RESULTS_LOG_SEGMENT_RECORDS
+                + std::min<size_t>(tail / hdr.record_size, RESULTS_LOG_SEGMENT_RECORDS);
+    return true;
+}
+
+void ResultsLogReader::close()
+{
+    if (base)
+        munmap((void *)base, size);
+    base = nullptr;
+    size = 0;
+    n_records = 0;
+}
+
+const ResultRecord &ResultsLogReader::record(uint64_t i) const
+{
+    uint64_t s = i / RESULTS_LOG_SEGMENT_RECORDS;
+    uint64_t r = i % RESULTS_LOG_SEGMENT_RECORDS;
+    return *(const ResultRecord *)(base + RESULTS_LOG_HEADER_SIZE + s * segment_stride + r * header().record_size);
+}
+
+const ResultsIndexBlock *ResultsLogReader::index_block(uint64_t s) const
+{
+    size_t offset = RESULTS_LOG_HEADER_SIZE + (s + 1) * segment_stride - sizeof(ResultsIndexBlock);
+    if (offset + sizeof(ResultsIndexBlock) > size)
+        return nullptr;
+    const ResultsIndexBlock *index = (const ResultsIndexBlock *)(base + offset);
+    return index->magic == RESULTS_INDEX_MAGIC ? index : nullptr;
+}
+
+int64_t ResultsLogReader::find_message(uint32_t message_id) const
+{
+    uint64_t n_segments = (n_records + RESULTS_LOG_SEGMENT_RECORDS - 1) / RESULTS_LOG_SEGMENT_RECORDS;
+    for (uint64_t s = 0; s < n_segments; s++) {
+        const ResultsIndexBlock *index = index_block(s);
+        if (index && (message_id < index->min_message_id || message_id > index->max_message_id))
+            continue;
+        uint64_t end = std::min<uint64_t>((s + 1) * RESULTS_LOG_SEGMENT_RECORDS, n_records);
+        for (uint64_t i = s * RESULTS_LOG_SEGMENT_RECORDS; i < end; i++) {
+            if (record(i).message_id == message_id)
+                return i;
+        }
+    }
+    return -1;
+}
+
+uint64_t ResultsLogReader::seek_time(uint64_t timestamp_ns) const
+{
+    // Ricerca binaria sui segmenti completi: il primo il cui massimo arriva a timestamp_ns
+    uint64_t lo = 0, hi = n_records / RESULTS_LOG_SEGMENT_RECORDS;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        const ResultsIndexBlock *index = index_block(mid);
+        if (index && index->max_timestamp_ns < timestamp_ns)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (uint64_t i = lo * RESULTS_LOG_SEGMENT_RECORDS; i < n_records; i++) {
+        if (record(i).timestamp_ns >= timestamp_ns)
+            return i;
+    }
+    return n_records;
+}
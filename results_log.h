@@ -0,0 +1,153 @@
+#ifndef RESULTS_LOG_H
+#define RESULTS_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message.h"
+
+// Log binario dei risultati decifrati dal receiver, in sola aggiunta e leggibile con mmap.
+//
+//   [ResultsLogHeader, 4096 byte]
+//   [record 0] ... [record RESULTS_LOG_SEGMENT_RECORDS-1] [ResultsIndexBlock]   <- segmento 0
+//   [record ...]                                       ... [ResultsIndexBlock]   <- segmento 1
+//   ...                                                                          <- ultimo segmento, senza indice finché non è pieno
+//
+// Ogni record ha dimensione fissa (header->record_size): ResultRecord seguito da slots_per_record
+// valori uint64_t. Il record i si trova quindi a un offset calcolabile, e l'indice alla fine di ogni
+// segmento (message_id e timestamp minimi e massimi) permette di saltare interi segmenti quando si
+// cerca per message_id o per tempo. I message_id non sono ordinati (più worker di decifratura), i
+// timestamp quasi: per questo l'indice riporta intervalli e non singoli valori
+constexpr char RESULTS_LOG_MAGIC[8] = {'H', 'E', 'T', 'L', 'O', 'G', '0', '1'};
+constexpr size_t RESULTS_LOG_HEADER_SIZE = 4096;
+constexpr uint32_t RESULTS_LOG_SEGMENT_RECORDS = 256;
+constexpr size_t RESULTS_LOG_MAX_SOURCES = 32;     // Voci della slot-map salvate in ogni record
+
+struct ResultsLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;         // Byte di un record (ResultRecord + valori)
+    uint32_t slots_per_record;    // Valori salvati per messaggio
+    uint32_t segment_records;     // Record per segmento (RESULTS_LOG_SEGMENT_RECORDS)
+    uint64_t plain_modulus;
+    uint64_t created_ns;          // CLOCK_REALTIME
+};
+
+enum ResultRecordFlags : uint16_t {
+    RESULT_SOURCES_TRUNCATED = 1 << 0,   // La slot-map aveva più di RESULTS_LOG_MAX_SOURCES voci
+    RESULT_SLOTS_TRUNCATED = 1 << 1,     // Il messaggio aveva più di slots_per_record slot
+};
+
+struct ResultRecord {
+    uint64_t timestamp_ns;        // Decifratura (CLOCK_REALTIME)
+    uint32_t message_id;
+    uint16_t n_sources;           // Voci valide in sources (0 = nessuna slot-map, stesso valore in tutti gli slot)
+    uint16_t flags;               // ResultRecordFlags
+    SlotMapEntry sources[RESULTS_LOG_MAX_SOURCES];
+    // Seguono slots_per_record valori uint64_t
+};
+
+struct ResultsIndexBlock {
+    uint64_t magic;               // RESULTS_INDEX_MAGIC
+    uint64_t segment;             // Numero del segmento
+    uint32_t min_message_id;
+    uint32_t max_message_id;
+    uint64_t min_timestamp_ns;
+    uint64_t max_timestamp_ns;
+    uint64_t reserved[3];
+};
+constexpr uint64_t RESULTS_INDEX_MAGIC = 0x5844494c4f544548ull;   // "HETLOIDX"
+
+static_assert(sizeof(ResultsLogHeader) <= RESULTS_LOG_HEADER_SIZE, "header troppo grande");
+static_assert(sizeof(ResultRecord) % 8 == 0, "i valori devono essere allineati a 8 byte");
+static_assert(sizeof(ResultsIndexBlock) == 64, "indice di una linea di cache");
+
+// Scrittura del log. append() è chiamato dai worker di decifratura: copia il record in un buffer
+// allineato (il lock copre solo la copia) e un thread dedicato scrive i buffer pieni con una write
+// da write_buffer_size byte. Se il disco resta indietro i record vengono scartati e contati
+class ResultsLogWriter {
+public:
+    ResultsLogWriter() = default;
+    ~ResultsLogWriter();
+
+    // Crea il file (o continua uno esistente con lo stesso formato). slots_per_record = valori salvati
+    // per messaggio (il grado del polinomio per salvarli tutti)
+    bool open(const std::string &path, uint32_t slots_per_record, uint64_t plain_modulus,
+              size_t write_buffer_size = 4 << 20);
+    void close();
+
+    void append(uint32_t message_id, const std::vector<SlotMapEntry> &slot_map, const std::vector<uint64_t> &values);
+
+    uint64_t get_written() const { return written.load(); }
+    uint64_t get_dropped() const { return dropped.load(); }
+
+private:
+    struct AlignedBuffer {
+        uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    void writer_loop();
+    void append_bytes(const void *bytes, size_t n);
+
+    int fd = -1;
+    uint32_t slots_per_record = 0;
+    uint32_t record_size = 0;
+    size_t buffer_capacity = 0;
+    std::vector<uint8_t> record;      // Record in costruzione (protetto da mtx)
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    AlignedBuffer filling;            // Buffer in riempimento (protetto da mtx)
+    std::vector<AlignedBuffer> full;  // Buffer pronti per la write (protetto da mtx)
+    std::vector<AlignedBuffer> spare; // Buffer liberi (protetto da mtx)
+    bool stopping = false;
+    std::thread writer;
+
+    // Segmento corrente (protetto da mtx)
+    uint64_t segment = 0;
+    uint32_t segment_count = 0;
+    ResultsIndexBlock index{};
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+// Lettura con mmap di un log (anche mentre viene scritto: count() considera solo i record completi
+// presenti al momento di open())
+class ResultsLogReader {
+public:
+    ResultsLogReader() = default;
+    ~ResultsLogReader();
+
+    bool open(const std::string &path);
+    void close();
+
+    const ResultsLogHeader &header() const { return *(const ResultsLogHeader *)base; }
+    uint64_t count() const { return n_records; }
+
+    const ResultRecord &record(uint64_t i) const;
+    const uint64_t *values(const ResultRecord &rec) const { return (const uint64_t *)(&rec + 1); }
+
+    // Indice del record con quel message_id, -1 se non c'è. Salta i segmenti il cui indice lo esclude
+    int64_t find_message(uint32_t message_id) const;
+    // Indice del primo record con timestamp >= timestamp_ns (count() se non ce ne sono)
+    uint64_t seek_time(uint64_t timestamp_ns) const;
+
+private:
+    // Indice del segmento s, nullptr se il segmento non è completo
+    const ResultsIndexBlock *index_block(uint64_t s) const;
+
+    const uint8_t *base = nullptr;
+    size_t size = 0;
+    uint64_t n_records = 0;
+    size_t segment_stride = 0;
+};
+
+#endif
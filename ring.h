@@ -0,0 +1,98 @@
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Coda circolare limitata senza lock, più produttori e più consumatori (schema di D. Vyukov,
+// lo stesso usato da rte_ring in modalità MP/MC). Ogni cella ha un numero di sequenza che dice
+// se è libera per il produttore o pronta per il consumatore: push e pop costano un CAS ciascuno
+// e non allocano memoria. La capacità viene arrotondata alla potenza di 2 successiva.
+// Non dipende da DPDK, così funziona con tutti i backend di I/O
+template <typename T>
+class BoundedRing {
+public:
+    explicit BoundedRing(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedRing(const BoundedRing &) = delete;
+    BoundedRing &operator=(const BoundedRing &) = delete;
+
+    // Ritorna false se la coda è piena
+    bool try_push(const T &value)
+    {
+        Cell *cell;
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Ritorna false se la coda è vuota
+    bool try_pop(T &value)
+    {
+        Cell *cell;
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        value = cell->value;
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Numero approssimato di elementi (esatto solo se nessuno sta facendo push o pop)
+    size_t size() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    // Su linee di cache diverse, per non far rimbalzare la stessa linea tra produttori e consumatori
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> head{0};
+};
+
+#endif
@@ -28,19 +28,24 @@
 #include <signal.h>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 // DPDK headers
 #include <rte_common.h>
 #include <rte_eal.h>
+#include <rte_errno.h>
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_flow.h>
+#include <rte_lcore.h>
 #include <rte_malloc.h>
 #include <rte_mbuf.h>
 #include <rte_mempool.h>
 #include <rte_net.h>
+#include <rte_power_pmd_mgmt.h>
 
 
 // DOCA specific headers
@@ -49,9 +54,10 @@
 #include <doca_log.h>
 
 #include <seal/seal.h>
-#include "packet_assembler.h"
-#include "message.h"
-#include "config.h"
+#include "forwarder.h"
+#include "packet_io_dpdk.h"
+#include "runtime_config.h"
+#include "seal_params.h"
 // error check macros:
 #define CHECK_NNEG(res) if ((res) < 0) { std::cerr << "result = " << (res) << std::endl; abort(); }
 #define CHECK_DERR(derr) if ((derr) != DOCA_SUCCESS) \
@@ -73,46 +79,6 @@ struct ip_addr {
 
 using namespace seal;
 
-// Classe per gestire operazioni omomorifiche
-class HEContext {
-public:
-    //Uso puntatori per facilitare l'inizializzazione nel costruttore
-    seal::SEALContext* context;
-    Evaluator* evaluator;
-    BatchEncoder* encoder;
-    
-    // Buffer pre-allocati per evitare allocazioni ripetute in add_plain_number
-    std::vector<uint64_t> values_buffer;
-    Plaintext ptx_buffer;
-    
-    HEContext() {
-        // Inizializzazione di SEAL con parametri da config.h
-        EncryptionParameters parms(scheme_type::bfv);
-        parms.set_poly_modulus_degree(POLY_MODULUS_DEGREE);
-        parms.set_coeff_modulus(CoeffModulus::BFVDefault(POLY_MODULUS_DEGREE));
-        parms.set_plain_modulus(PLAIN_MODULUS);
-        
-        context = new seal::SEALContext(parms);
-        evaluator = new Evaluator(*context);
-        encoder = new BatchEncoder(*context);
-        
-        values_buffer.resize(encoder->slot_count());
-    }
-    
-    ~HEContext() {
-        delete encoder;
-        delete evaluator;
-        delete context;
-    }
-    
-    // Somma un numero in chiaro al ciphertext
-    void add_plain_number(Ciphertext& ct, uint64_t number) {
-        std::fill(values_buffer.begin(), values_buffer.end(), number);
-        encoder->encode(values_buffer, ptx_buffer);
-        evaluator->add_plain_inplace(ct, ptx_buffer);
-    }
-};
-
 /// Structure containing the full configuration
 /// of this application
 struct app_005_cfg
@@ -125,12 +91,26 @@ struct app_005_cfg
         // DPDK, in order to handle packets in software, requires
         // mbuf allocation
         //  https://doc.dpdk.org/api/rte__mbuf_8h.html
+        // Un pool per ogni socket NUMA su cui girano i lcore worker:
+        // il nome è seguito dall'id del socket
         static constexpr char mbuf_pool_name[] = "MBUF_POOL";
-        // number of element in the mbuf pool
-        static constexpr int mbuf_pool_size = (1 << 14) - 1;
+        // I parametri seguenti si possono cambiare dalla
+        // linea di comando (dopo '--', vedi configure_doca_parser)
+        // number of element in the mbuf pool (per socket)
+        int mbuf_pool_size = (1 << 14) - 1;
+        // per lcore cache: senza cache ogni alloc/free
+        // passa dal ring condiviso del mempool
+        int mbuf_cache_size = 256;
         // size reserver for each packet, I do not expect
         // packets to be bigger than that (no jumboframes)
-        static constexpr int mbuf_pool_pkt_buf_size = (1 << 11);
+        int mbuf_data_room = (1 << 11);
+
+        // Power management delle code RX (rte_power PMD management,
+        // "--power-mgmt monitor|pause|scale"): quando le code di un
+        // lcore restano vuote è il PMD a sospenderlo (UMWAIT/TPAUSE o
+        // frequenza più bassa) e il backoff software viene disattivato
+        bool power_mgmt = false;
+        enum rte_power_pmd_mgmt_type power_mgmt_type = RTE_POWER_MGMT_TYPE_PAUSE;
 
         struct {
             uint16_t port_id = 0;
@@ -150,13 +130,23 @@ struct app_005_cfg
         int nb_rxtx_queues = 0;
         std::vector<uint16_t> rxtx_queues;
 
-        // Usa le costanti da config.h
-        static constexpr uint16_t nb_ring_rx_size = RX_QUEUE_SIZE;
-        static constexpr uint16_t nb_ring_tx_size = TX_QUEUE_SIZE;
+        // Code hairpin (RX di una porta collegata al TX dell'altra, senza passare dalla CPU):
+        // usate per inoltrare in hardware il traffico che non è telemetria.
+        // Hanno indice nb_rxtx_queues, dopo le code per il software
+        static constexpr int nb_hairpin_queues = 1;
 
-        // pointer to buffer pool : must be deallocated
-        // on application termination
-        struct rte_mempool *mbuf_pool = nullptr;
+        // Dimensioni delle code: runtime_config().rx_queue_size
+        // e tx_queue_size (default da config.h)
+
+        // buffer pools, indexed by NUMA socket id (nullptr
+        // for sockets without worker lcores): must be
+        // deallocated on application termination
+        std::vector<struct rte_mempool *> mbuf_pools;
+
+        // lcore id and NUMA socket of each worker,
+        // indexed by lcore index
+        std::vector<unsigned> worker_lcores;
+        std::vector<unsigned> worker_sockets;
     } dpdk;
 
     // DOCA configuration
@@ -245,6 +235,121 @@ static doca_error_t init_dpdk(int argc, char *argv[])
 }
 
 
+// Callback dei parametri dei mempool (config è la app_005_cfg passata a doca_argp_init)
+static doca_error_t mbuf_pool_size_callback(void *param, void *config)
+{
+    ((struct app_005_cfg *)config)->dpdk.mbuf_pool_size = *(int *)param;
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t mbuf_cache_size_callback(void *param, void *config)
+{
+    ((struct app_005_cfg *)config)->dpdk.mbuf_cache_size = *(int *)param;
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t mbuf_data_room_callback(void *param, void *config)
+{
+    ((struct app_005_cfg *)config)->dpdk.mbuf_data_room = *(int *)param;
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t power_mgmt_callback(void *param, void *config)
+{
+    struct app_005_cfg::dpdk &dpdk = ((struct app_005_cfg *)config)->dpdk;
+    const std::string mode = (const char *)param;
+
+    dpdk.power_mgmt = true;
+    if (mode == "none")
+        dpdk.power_mgmt = false;
+    else if (mode == "monitor")
+        dpdk.power_mgmt_type = RTE_POWER_MGMT_TYPE_MONITOR;
+    else if (mode == "pause")
+        dpdk.power_mgmt_type = RTE_POWER_MGMT_TYPE_PAUSE;
+    else if (mode == "scale")
+        dpdk.power_mgmt_type = RTE_POWER_MGMT_TYPE_SCALE;
+    else
+    {
+        std::cerr << "power-mgmt: valori ammessi none, monitor, pause, scale" << std::endl;
+        return DOCA_ERROR_INVALID_VALUE;
+    }
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t register_int_param(const char *long_name, const char *description,
+                                       doca_argp_param_cb_t callback)
+{
+    doca_error_t result;
+    struct doca_argp_param *param = nullptr;
+
+    result = doca_argp_param_create(&param);
+    CHECK_DERR(result);
+    doca_argp_param_set_long_name(param, long_name);
+    doca_argp_param_set_description(param, description);
+    doca_argp_param_set_callback(param, callback);
+    doca_argp_param_set_type(param, DOCA_ARGP_TYPE_INT);
+    result = doca_argp_register_param(param);
+    CHECK_DERR(result);
+
+    return DOCA_SUCCESS;
+}
+
+
+// Parametri di runtime_config.h: una callback per parametro (le callback di argp non ricevono il nome),
+// generate a compile time dalla tabella CONFIG_OPTIONS
+template <size_t I>
+static doca_error_t config_option_callback(void *param, void *config)
+{
+    (void)config;
+    if (!set_config_option(runtime_config(), CONFIG_OPTIONS[I].name, (const char *)param))
+    {
+        return DOCA_ERROR_INVALID_VALUE;
+    }
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t config_file_callback(void *param, void *config)
+{
+    (void)config;
+    if (!load_config_file(runtime_config(), (const char *)param))
+    {
+        return DOCA_ERROR_INVALID_VALUE;
+    }
+    return DOCA_SUCCESS;
+}
+
+static doca_error_t register_string_param(const char *long_name, const char *description,
+                                          doca_argp_param_cb_t callback)
+{
+    doca_error_t result;
+    struct doca_argp_param *param = nullptr;
+
+    result = doca_argp_param_create(&param);
+    CHECK_DERR(result);
+    doca_argp_param_set_long_name(param, long_name);
+    doca_argp_param_set_description(param, description);
+    doca_argp_param_set_callback(param, callback);
+    doca_argp_param_set_type(param, DOCA_ARGP_TYPE_STRING);
+    result = doca_argp_register_param(param);
+    CHECK_DERR(result);
+
+    return DOCA_SUCCESS;
+}
+
+template <size_t... I>
+static doca_error_t register_config_params(std::index_sequence<I...>)
+{
+    doca_error_t results[] = {
+        register_string_param(CONFIG_OPTIONS[I].name, CONFIG_OPTIONS[I].description, config_option_callback<I>)...
+    };
+    for (doca_error_t result : results)
+    {
+        CHECK_DERR(result);
+    }
+    return DOCA_SUCCESS;
+}
+
+
 static doca_error_t configure_doca_parser(struct app_005_cfg &cfg)
 {
     doca_error_t result;
@@ -263,39 +368,192 @@ static doca_error_t configure_doca_parser(struct app_005_cfg &cfg)
     result = doca_argp_register_version_callback(my_doca_version_callback);
     CHECK_DERR(result);
 
+    // mempool parameters (e.g. "-- --mbuf-cache-size 512")
+    result = register_int_param("mbuf-pool-size", "number of mbufs in each per NUMA socket pool", mbuf_pool_size_callback);
+    CHECK_DERR(result);
+    result = register_int_param("mbuf-cache-size", "per lcore mbuf cache size (0 = no cache)", mbuf_cache_size_callback);
+    CHECK_DERR(result);
+    result = register_int_param("mbuf-data-room", "mbuf data room size, headroom included", mbuf_data_room_callback);
+    CHECK_DERR(result);
+
+    // RX queues power management (e.g. "-- --power-mgmt monitor")
+    result = register_string_param("power-mgmt", "PMD power management of idle RX queues: none, monitor, pause, scale (not with steering, tenant scheduling or aggregation)", power_mgmt_callback);
+    CHECK_DERR(result);
+
+    // runtime parameters (e.g. "-- --config forwarder.conf --burst-size 64"), applied in command line order
+    result = register_string_param("config", "file with \"name = value\" runtime parameters", config_file_callback);
+    CHECK_DERR(result);
+    result = register_config_params(std::make_index_sequence<N_CONFIG_OPTIONS>());
+    CHECK_DERR(result);
+
     std::cout << "DOCA parser configured" << std::endl;
 
     return DOCA_SUCCESS;
 }
 
 
+// Id di ogni lcore, in ordine di rte_lcore_index
+// (lo stesso ordine degli worker e delle code)
+static std::vector<unsigned> get_worker_lcores()
+{
+    std::vector<unsigned> lcores(rte_lcore_count(), 0);
+    for (unsigned lcore_id = 0; lcore_id < RTE_MAX_LCORE; ++lcore_id)
+    {
+        int index = rte_lcore_index(lcore_id);
+        if (rte_lcore_is_enabled(lcore_id) && index >= 0)
+        {
+            lcores[index] = lcore_id;
+        }
+    }
+    return lcores;
+}
+
+
 static doca_error_t configure_dpdk_mbuf_pool(struct app_005_cfg::dpdk &dpdk)
 {
-    struct rte_mempool *mbuf_pool = nullptr;
-
-    mbuf_pool = rte_pktmbuf_pool_create(
-        app_005_cfg::dpdk::mbuf_pool_name,
-        app_005_cfg::dpdk::mbuf_pool_size,
-        /* per thread cache size */ 0,
-        /* private (application) data size */ 0,
-        app_005_cfg::dpdk::mbuf_pool_pkt_buf_size,
-        rte_socket_id()
-    );
-    if (!mbuf_pool)
+    dpdk.worker_lcores = get_worker_lcores();
+    dpdk.worker_sockets.clear();
+    for (unsigned lcore_id : dpdk.worker_lcores)
     {
-        std::cerr << "rte_pktmbuf_pool_create failed" << std::endl;
-        abort();
+        dpdk.worker_sockets.push_back(rte_lcore_to_socket_id(lcore_id));
     }
+    dpdk.mbuf_pools.assign(RTE_MAX_NUMA_NODES, nullptr);
+
+    // the per lcore cache cannot be bigger than
+    // RTE_MEMPOOL_CACHE_MAX_SIZE and than pool size / 1.5
+    const int max_cache_size = std::min<int>(RTE_MEMPOOL_CACHE_MAX_SIZE, dpdk.mbuf_pool_size / 1.5);
+    if (dpdk.mbuf_cache_size > max_cache_size)
+    {
+        std::cerr << "mbuf cache size " << dpdk.mbuf_cache_size << " too big, using " << max_cache_size << std::endl;
+        dpdk.mbuf_cache_size = max_cache_size;
+    }
+
+    // one pool per NUMA socket used by the workers: mbufs
+    // (and the RX queues that use them) stay local to the
+    // lcores that process the packets
+    for (int q = 0; q < dpdk.nb_rxtx_queues; ++q)
+    {
+        const unsigned socket = dpdk.worker_sockets[q];
+        if (dpdk.mbuf_pools[socket])
+        {
+            continue;
+        }
 
-    // set mbuf pool
-    dpdk.mbuf_pool = mbuf_pool;
+        char name[RTE_MEMPOOL_NAMESIZE];
+        snprintf(name, sizeof(name), "%s_%u", app_005_cfg::dpdk::mbuf_pool_name, socket);
+
+        struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create(
+            name,
+            dpdk.mbuf_pool_size,
+            /* per thread cache size */ dpdk.mbuf_cache_size,
+            /* private (application) data size */ 0,
+            dpdk.mbuf_data_room,
+            socket
+        );
+        if (!mbuf_pool)
+        {
+            std::cerr << "rte_pktmbuf_pool_create failed on socket " << socket << ": " << rte_strerror(rte_errno) << std::endl;
+            abort();
+        }
+
+        std::cout << "mbuf pool " << name << ": " << dpdk.mbuf_pool_size << " mbufs, cache "
+                  << dpdk.mbuf_cache_size << ", data room " << dpdk.mbuf_data_room << std::endl;
+
+        // set mbuf pool
+        dpdk.mbuf_pools[socket] = mbuf_pool;
+    }
 
     return DOCA_SUCCESS;
 }
 
 
+// Utilizzo dei pool: mbuf in uso (nelle code RX, nelle cache dei lcore o in elaborazione) sul totale
+static void print_mbuf_pool_usage(const struct app_005_cfg::dpdk &dpdk)
+{
+    for (const struct rte_mempool *pool : dpdk.mbuf_pools)
+    {
+        if (!pool)
+        {
+            continue;
+        }
+        const unsigned in_use = rte_mempool_in_use_count(pool);
+        std::cout << "mbuf pool " << pool->name << ": " << in_use << "/" << pool->size
+                  << " in use (" << (100.0 * in_use / pool->size) << "%)" << std::endl;
+    }
+}
+
+
+// Crea la coda hairpin queue_id di port_id: i pacchetti ricevuti su port_id escono dalla
+// coda TX hairpin di peer_port_id (e viceversa per la coda TX), interamente nella NIC
+static void setup_hairpin_queues(uint16_t port_id, uint16_t peer_port_id, uint16_t queue_id)
+{
+    int ret;
+    struct rte_eth_hairpin_cap cap;
+    struct rte_eth_hairpin_conf hairpin_conf;
+
+    ret = rte_eth_dev_hairpin_capability_get(port_id, &cap);
+    if (ret != 0)
+    {
+        std::cerr << "Port " << port_id << " does not support hairpin queues" << std::endl;
+        abort();
+    }
+
+    memset(&hairpin_conf, 0, sizeof(hairpin_conf));
+    hairpin_conf.peer_count = 1;
+    // Collegamento esplicito con rte_eth_hairpin_bind, perché il peer è un'altra porta
+    hairpin_conf.manual_bind = 1;
+    hairpin_conf.tx_explicit = 1;
+    hairpin_conf.peers[0].port = peer_port_id;
+    hairpin_conf.peers[0].queue = queue_id;
+
+    ret = rte_eth_rx_hairpin_queue_setup(port_id, queue_id, runtime_config().rx_queue_size, &hairpin_conf);
+    CHECK_NNEG(ret);
+    ret = rte_eth_tx_hairpin_queue_setup(port_id, queue_id, runtime_config().tx_queue_size, &hairpin_conf);
+    CHECK_NNEG(ret);
+}
+
+
 // configure DPDK ports and queues
 // initialize ingress and egress port queues
+// Power management delle code software di una porta (va fatto a porta ferma):
+// ogni coda q è associata al lcore che la serve. Con più code per lcore
+// (ingress ed egress) il PMD sospende il lcore solo quando sono vuote tutte.
+// Le altre sorgenti di lavoro del lcore (steering, tenant, timer) non lo
+// risvegliano: main rifiuta la combinazione.
+// Se il driver non supporta la modalità richiesta si prosegue senza
+static void enable_power_mgmt(struct app_005_cfg::dpdk &dpdk, uint16_t port_id)
+{
+    if (!dpdk.power_mgmt)
+    {
+        return;
+    }
+
+    for (int q = 0; q < dpdk.nb_rxtx_queues; ++q)
+    {
+        int ret = rte_power_ethdev_pmgmt_queue_enable(dpdk.worker_lcores[q], port_id, q, dpdk.power_mgmt_type);
+        if (ret < 0)
+        {
+            std::cerr << "rte_power_ethdev_pmgmt_queue_enable failed on port " << port_id << " queue " << q
+                      << ": " << rte_strerror(-ret) << std::endl;
+        }
+    }
+}
+
+static void disable_power_mgmt(struct app_005_cfg::dpdk &dpdk, uint16_t port_id)
+{
+    if (!dpdk.power_mgmt)
+    {
+        return;
+    }
+
+    // errore ignorato: la coda potrebbe non essere stata abilitata
+    for (int q = 0; q < dpdk.nb_rxtx_queues; ++q)
+    {
+        rte_power_ethdev_pmgmt_queue_disable(dpdk.worker_lcores[q], port_id, q);
+    }
+}
+
+
 static doca_error_t configure_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dpdk)
 {
     doca_error_t result;
@@ -334,6 +592,12 @@ static doca_error_t configure_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dp
     // number of threads activated by DPDK: it is
     // important because
     dpdk.nb_dpdk_threads = ret;
+    // worker_id (rte_lcore_index) indicizza le statistiche per lcore
+    if (ret > (int)STATS_MAX_LCORES)
+    {
+        std::cerr << "ERROR: " << ret << " lcore, at most " << STATS_MAX_LCORES << " supported" << std::endl;
+        abort();
+    }
     // the number of useful threads is the minimum between
     // the number of expected queues and the CPU count
     // Non ha senso avere più code che thread
@@ -384,10 +648,10 @@ static doca_error_t configure_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dp
         // set default conf
         ret = rte_eth_dev_configure(
             dpdk.ingress.port_id,
-            // RX queues are all regular queues for software
-            dpdk.nb_rxtx_queues,
-            // TX queues are all regular queues for software
-            dpdk.nb_rxtx_queues,
+            // RX queues: regular queues for software + hairpin
+            dpdk.nb_rxtx_queues + app_005_cfg::dpdk::nb_hairpin_queues,
+            // TX queues: regular queues for software + hairpin
+            dpdk.nb_rxtx_queues + app_005_cfg::dpdk::nb_hairpin_queues,
             &port_conf
         );
         CHECK_NNEG(ret);
@@ -395,31 +659,37 @@ static doca_error_t configure_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dp
         // allocate TX and RX queues
         for (int q = 0; q < dpdk.nb_rxtx_queues; ++q)
         {
+            // queue q is served by the worker with lcore index q:
+            // descriptors and mbufs on its NUMA socket
+            const unsigned socket = dpdk.worker_sockets[q];
             ret = rte_eth_rx_queue_setup(
                 dpdk.ingress.port_id,
                 q,
-                app_005_cfg::dpdk::nb_ring_rx_size,
-                rte_socket_id(),
+                runtime_config().rx_queue_size,
+                socket,
                 /* default conf */ nullptr,
-                dpdk.mbuf_pool
+                dpdk.mbuf_pools[socket]
             );
             CHECK_NNEG(ret);
             ret = rte_eth_tx_queue_setup(
                 dpdk.ingress.port_id,
                 q,
-                app_005_cfg::dpdk::nb_ring_tx_size,
-                rte_socket_id(),
+                runtime_config().tx_queue_size,
+                socket,
                 /* default conf */ nullptr
             );
             CHECK_NNEG(ret);
         }
-        // nothing to do for hairpin queues
+        // hairpin queues towards the egress port
+        setup_hairpin_queues(dpdk.ingress.port_id, dpdk.egress.port_id, dpdk.nb_rxtx_queues);
 
         // enable promiscuos mode, to allow packet
         // receiption for pkt forwarding
         ret = rte_eth_promiscuous_enable(dpdk.ingress.port_id);
         CHECK_NNEG(ret);
 
+        enable_power_mgmt(dpdk, dpdk.ingress.port_id);
+
         // enable DPDK port
         ret = rte_eth_dev_start(dpdk.ingress.port_id);
         CHECK_NNEG(ret);
@@ -438,40 +708,53 @@ static doca_error_t configure_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dp
 
         ret = rte_eth_dev_configure(
             dpdk.egress.port_id,
-            dpdk.nb_rxtx_queues,
-            dpdk.nb_rxtx_queues,
+            dpdk.nb_rxtx_queues + app_005_cfg::dpdk::nb_hairpin_queues,
+            dpdk.nb_rxtx_queues + app_005_cfg::dpdk::nb_hairpin_queues,
             &port_conf
         );
         CHECK_NNEG(ret);
 
         for (int q = 0; q < dpdk.nb_rxtx_queues; ++q)
         {
+            const unsigned socket = dpdk.worker_sockets[q];
             ret = rte_eth_rx_queue_setup(
                 dpdk.egress.port_id,
                 q,
-                app_005_cfg::dpdk::nb_ring_rx_size,
-                rte_socket_id(),
+                runtime_config().rx_queue_size,
+                socket,
                 /* default conf */ nullptr,
-                dpdk.mbuf_pool
+                dpdk.mbuf_pools[socket]
             );
             CHECK_NNEG(ret);
             ret = rte_eth_tx_queue_setup(
                 dpdk.egress.port_id,
                 q,
-                app_005_cfg::dpdk::nb_ring_tx_size,
-                rte_socket_id(),
+                runtime_config().tx_queue_size,
+                socket,
                 /* default conf */ nullptr
             );
             CHECK_NNEG(ret);
         }
 
+        // hairpin queues towards the ingress port
+        setup_hairpin_queues(dpdk.egress.port_id, dpdk.ingress.port_id, dpdk.nb_rxtx_queues);
+
         ret = rte_eth_promiscuous_enable(dpdk.egress.port_id);
         CHECK_NNEG(ret);
 
+        enable_power_mgmt(dpdk, dpdk.egress.port_id);
+
         ret = rte_eth_dev_start(dpdk.egress.port_id);
         CHECK_NNEG(ret);
     }
 
+    // Le code hairpin sono in manual bind: il collegamento si può fare solo con entrambe le porte avviate
+    // (rte_eth_hairpin_bind(tx_port, rx_port))
+    ret = rte_eth_hairpin_bind(dpdk.ingress.port_id, dpdk.egress.port_id);
+    CHECK_NNEG(ret);
+    ret = rte_eth_hairpin_bind(dpdk.egress.port_id, dpdk.ingress.port_id);
+    CHECK_NNEG(ret);
+
     return DOCA_SUCCESS;
 }
 
@@ -480,18 +763,35 @@ static doca_error_t dispose_dpdk_ports_and_queues(struct app_005_cfg::dpdk &dpdk
 {
     int ret;
 
+    // unbind hairpin queues
+    ret = rte_eth_hairpin_unbind(dpdk.ingress.port_id, dpdk.egress.port_id);
+    CHECK_NNEG(ret);
+    ret = rte_eth_hairpin_unbind(dpdk.egress.port_id, dpdk.ingress.port_id);
+    CHECK_NNEG(ret);
+
     // stop ports
     ret = rte_eth_dev_stop(dpdk.ingress.port_id);
     CHECK_NNEG(ret);
     ret = rte_eth_dev_stop(dpdk.egress.port_id);
     CHECK_NNEG(ret);
 
+    // power management (with stopped ports)
+    disable_power_mgmt(dpdk, dpdk.ingress.port_id);
+    disable_power_mgmt(dpdk, dpdk.egress.port_id);
+
     // close devices
     ret = rte_eth_dev_close(dpdk.ingress.port_id);
     CHECK_NNEG(ret);
     ret = rte_eth_dev_close(dpdk.egress.port_id);
     CHECK_NNEG(ret);
 
+    // free buffer pools (after the devices, whose queues use them)
+    for (auto &pool : dpdk.mbuf_pools)
+    {
+        rte_mempool_free(pool);
+        pool = nullptr;
+    }
+
     return DOCA_SUCCESS;
 }
 
@@ -633,174 +933,121 @@ static doca_error_t activate_doca_port(struct doca_flow_port *&port, uint16_t po
 }
 
 
-static doca_error_t configure_pipe_of_ingress_port(struct app_005_cfg &cfg)
+// Root pipe di una porta: solo i frammenti di telemetria (UDP verso base_port..base_port+n_ports-1)
+// vanno alla CPU con RSS; tutto il resto viene inoltrato in hardware all'altra porta (hairpin),
+// così il traffico di fondo non ruba cicli alle operazioni HE.
+// È una pipe di controllo: le entry hanno priorità diverse (0 = la più alta), la prima che fa
+// match decide. Una entry per porta UDP della telemetria, più una entry "catch-all" di priorità inferiore
+static doca_error_t configure_root_pipe(struct app_005_cfg &cfg, struct doca_flow_port *port,
+                                        uint16_t peer_port_id, const char *name,
+                                        struct doca_flow_pipe *&root_pipe)
 {
-    constexpr int num_actions = 1;
     constexpr int entries_submission_queue = 0;
-    constexpr int num_entries = 1;
+    const RuntimeConfig &rcfg = runtime_config();
+    const int num_entries = rcfg.n_ports + 1;
     constexpr int entries_submission_timeout_us = 100000; // 100 ms
+    constexpr uint32_t telemetry_priority = 0;
+    constexpr uint32_t passthrough_priority = 1;
 
     doca_error_t result;
     struct doca_flow_pipe_cfg *pipe_cfg = nullptr;
-    struct doca_flow_match match;
-    struct doca_flow_actions actions, *actions_arr[num_actions] = {};
-    struct doca_flow_fwd fwd, fwd_miss;
+    struct doca_flow_match match, match_mask;
+    struct doca_flow_fwd fwd_rss, fwd_peer;
     struct doca_flow_pipe_entry *entry = nullptr;
 
-    memset(&match, 0, sizeof(match));
-    memset(&actions, 0, sizeof(actions));
-    memset(&fwd, 0, sizeof(fwd));
-    memset(&fwd_miss, 0, sizeof(fwd_miss));
-    actions_arr[0] = &actions;
+    memset(&fwd_rss, 0, sizeof(fwd_rss));
+    memset(&fwd_peer, 0, sizeof(fwd_peer));
 
-    std::cout << "Configuring DOCA Flow Pipe for ingress port..." << std::endl;
+    std::cout << "Configuring DOCA Flow Pipe " << name << "..." << std::endl;
 
-    result = doca_flow_pipe_cfg_create(&pipe_cfg, cfg.doca.ingress.port);
+    result = doca_flow_pipe_cfg_create(&pipe_cfg, port);
     CHECK_DERR(result);
 
-    result = doca_flow_pipe_cfg_set_name(pipe_cfg, "INGRESS_PIPE");
+    result = doca_flow_pipe_cfg_set_name(pipe_cfg, name);
     CHECK_DERR(result);
 
-    // Questa pipe è root pipe ==> i pacchetti in ingresso alla porta 0 passano prima qua
+    // Questa pipe è root pipe ==> i pacchetti in ingresso alla porta passano prima qua
     result = doca_flow_pipe_cfg_set_is_root(pipe_cfg, true);
     CHECK_DERR(result);
 
     result = doca_flow_pipe_cfg_set_domain(pipe_cfg, DOCA_FLOW_PIPE_DOMAIN_DEFAULT);
     CHECK_DERR(result);
 
-    // Non faccio alcuna action
-    result = doca_flow_pipe_cfg_set_actions(pipe_cfg, actions_arr, nullptr, nullptr, num_actions);
+    // Nelle pipe di controllo match e forwarding sono specificati per ogni entry
+    result = doca_flow_pipe_cfg_set_type(pipe_cfg, DOCA_FLOW_PIPE_CONTROL);
     CHECK_DERR(result);
 
-    result = doca_flow_pipe_cfg_set_match(pipe_cfg, &match, nullptr);
+    result = doca_flow_pipe_create(pipe_cfg, nullptr, nullptr, &root_pipe);
     CHECK_DERR(result);
 
-    result = doca_flow_pipe_cfg_set_type(pipe_cfg, DOCA_FLOW_PIPE_BASIC);
+    result = doca_flow_pipe_cfg_destroy(pipe_cfg);
     CHECK_DERR(result);
+    pipe_cfg = nullptr;
 
-    // Usa forwarding RSS ==> i pacchetti vanno alla CPU
-    fwd.type = DOCA_FLOW_FWD_RSS;
-    fwd.rss_queues = cfg.dpdk.rxtx_queues.data();
-    fwd.num_of_queues = cfg.dpdk.nb_rxtx_queues;
+    // Telemetria: forwarding RSS ==> i pacchetti vanno alla CPU
+    fwd_rss.type = DOCA_FLOW_FWD_RSS;
+    fwd_rss.rss_queues = cfg.dpdk.rxtx_queues.data();
+    fwd_rss.num_of_queues = cfg.dpdk.nb_rxtx_queues;
     // L'hash viene calcolato su questi campi...
-    fwd.rss_outer_flags = DOCA_FLOW_RSS_IPV4 | DOCA_FLOW_RSS_IPV6 | DOCA_FLOW_RSS_UDP | DOCA_FLOW_RSS_TCP;
-    // I pacchetti che non fanno match vengono droppata (qua il match è sempre true)
-    fwd_miss.type = DOCA_FLOW_FWD_DROP;
+    fwd_rss.rss_outer_flags = DOCA_FLOW_RSS_IPV4 | DOCA_FLOW_RSS_UDP;
 
-    // Creazione pipe
-    result = doca_flow_pipe_create(pipe_cfg, &fwd, &fwd_miss, &cfg.doca.ingress.root_pipe);
-    CHECK_DERR(result);
+    for (uint16_t i = 0; i < rcfg.n_ports; i++)
+    {
+        memset(&match, 0, sizeof(match));
+        memset(&match_mask, 0, sizeof(match_mask));
+        match.outer.l3_type = DOCA_FLOW_L3_TYPE_IP4;
+        match.outer.l4_type_ext = DOCA_FLOW_L4_TYPE_EXT_UDP;
+        match.outer.udp.l4_port.dst_port = rte_cpu_to_be_16(rcfg.base_port + i);
+        match_mask.outer.udp.l4_port.dst_port = 0xffff;
+
+        result = doca_flow_pipe_control_add_entry(
+            entries_submission_queue, telemetry_priority, root_pipe,
+            &match, &match_mask, nullptr,
+            nullptr, nullptr, nullptr, nullptr,
+            &fwd_rss, nullptr, &entry
+        );
+        CHECK_DERR(result);
+    }
 
-    result = doca_flow_pipe_cfg_destroy(pipe_cfg);
-    CHECK_DERR(result);
-    pipe_cfg = nullptr;
+    // Tutto il resto: forwarding verso l'altra porta (la coppia di porte usa le code hairpin)
+    memset(&match, 0, sizeof(match));
+    memset(&match_mask, 0, sizeof(match_mask));
+    fwd_peer.type = DOCA_FLOW_FWD_PORT;
+    fwd_peer.port_id = peer_port_id;
 
-    result = doca_flow_pipe_add_entry(
-        entries_submission_queue,
-        cfg.doca.ingress.root_pipe,
+    result = doca_flow_pipe_control_add_entry(
+        entries_submission_queue, passthrough_priority, root_pipe,
+        &match, &match_mask, nullptr,
         nullptr, nullptr, nullptr, nullptr,
-        // DOCA_FLOW_WAIT_FOR_BATCH => invoke doca_flow_entries_process
-        // to push entries to hw
-        DOCA_FLOW_WAIT_FOR_BATCH /* DOCA_FLOW_NO_WAIT */,
-        nullptr,
-        &entry
+        &fwd_peer, nullptr, &entry
     );
     CHECK_DERR(result);
 
-
     result = doca_flow_entries_process(
-        cfg.doca.ingress.port,
+        port,
         entries_submission_queue,
         entries_submission_timeout_us,
         num_entries
     );
-    CHECK_DERR(result);    
+    CHECK_DERR(result);
 
-    std::cout << "DOCA Flow Pipe for ingress port configured" << std::endl;
+    std::cout << "DOCA Flow Pipe " << name << " configured" << std::endl;
 
     return DOCA_SUCCESS;
 }
 
 
-static doca_error_t configure_pipe_of_egress_port(struct app_005_cfg &cfg)
+static doca_error_t configure_pipe_of_ingress_port(struct app_005_cfg &cfg)
 {
-    constexpr int num_actions = 1;
-    constexpr int entries_submission_queue = 0;
-    constexpr int num_entries = 1;
-    constexpr int entries_submission_timeout_us = 10000; // 10 ms
-
-    doca_error_t result;
-    struct doca_flow_pipe_cfg *pipe_cfg = nullptr;
-    struct doca_flow_match match;
-    struct doca_flow_actions actions, *actions_arr[num_actions] = {};
-    struct doca_flow_fwd fwd, fwd_miss;
-    struct doca_flow_pipe_entry *entry = nullptr;
-
-    memset(&match, 0, sizeof(match));
-    memset(&actions, 0, sizeof(actions));
-    memset(&fwd, 0, sizeof(fwd));
-    memset(&fwd_miss, 0, sizeof(fwd_miss));
-    actions_arr[0] = &actions;
-
-    std::cout << "Configuring DOCA Flow Pipe for egress port..." << std::endl;
-
-    result = doca_flow_pipe_cfg_create(&pipe_cfg, cfg.doca.egress.port);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_name(pipe_cfg, "EGRESS_PIPE");
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_is_root(pipe_cfg, true);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_domain(pipe_cfg, DOCA_FLOW_PIPE_DOMAIN_DEFAULT);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_actions(pipe_cfg, actions_arr, nullptr, nullptr, num_actions);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_match(pipe_cfg, &match, nullptr);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_set_type(pipe_cfg, DOCA_FLOW_PIPE_BASIC);
-    CHECK_DERR(result);
-
-    fwd.type = DOCA_FLOW_FWD_RSS;
-    fwd.rss_queues = cfg.dpdk.rxtx_queues.data();
-    fwd.num_of_queues = cfg.dpdk.nb_rxtx_queues;
-    fwd.rss_outer_flags = DOCA_FLOW_RSS_IPV4 | DOCA_FLOW_RSS_IPV6 | DOCA_FLOW_RSS_UDP | DOCA_FLOW_RSS_TCP;
-    fwd_miss.type = DOCA_FLOW_FWD_DROP;
-    result = doca_flow_pipe_create(pipe_cfg, &fwd, &fwd_miss, &cfg.doca.egress.root_pipe);
-    CHECK_DERR(result);
-
-    result = doca_flow_pipe_cfg_destroy(pipe_cfg);
-    CHECK_DERR(result);
-    pipe_cfg = nullptr;
-
-     result = doca_flow_pipe_add_entry(
-        entries_submission_queue,
-        cfg.doca.egress.root_pipe,
-        nullptr, nullptr, nullptr, nullptr,
-        // DOCA_FLOW_WAIT_FOR_BATCH => invoke doca_flow_entries_process
-        // to push entries to hw
-        DOCA_FLOW_WAIT_FOR_BATCH /* DOCA_FLOW_NO_WAIT */,
-        nullptr,
-        &entry
-    );
-    CHECK_DERR(result);
-
-
-    result = doca_flow_entries_process(
-        cfg.doca.egress.port,
-        entries_submission_queue,
-        entries_submission_timeout_us,
-        num_entries
-    );
-    CHECK_DERR(result);
+    return configure_root_pipe(cfg, cfg.doca.ingress.port, cfg.dpdk.egress.port_id,
+                               "INGRESS_PIPE", cfg.doca.ingress.root_pipe);
+}
 
-    std::cout << "DOCA Flow Pipe for egress port configured" << std::endl;
 
-    return DOCA_SUCCESS;
+static doca_error_t configure_pipe_of_egress_port(struct app_005_cfg &cfg)
+{
+    return configure_root_pipe(cfg, cfg.doca.egress.port, cfg.dpdk.ingress.port_id,
+                               "EGRESS_PIPE", cfg.doca.egress.root_pipe);
 }
 
 
@@ -815,7 +1062,10 @@ static doca_error_t configure_doca_ports(struct app_005_cfg &cfg)
     result = activate_doca_port(cfg.doca.egress.port, cfg.dpdk.egress.port_id);
     CHECK_DERR(result);
 
-    // no hairpin, so no use of doca_flow_port_pair
+    // Il traffico che non è telemetria passa da una porta all'altra in hardware (hairpin):
+    // le due porte vanno accoppiate
+    result = doca_flow_port_pair(cfg.doca.ingress.port, cfg.doca.egress.port);
+    CHECK_DERR(result);
 
     return DOCA_SUCCESS;
 }
@@ -874,11 +1124,14 @@ static doca_error_t cleanup_doca(struct app_005_cfg &cfg)
 // user code will loop untill exit will be requested
 static std::atomic_bool exit_request(false);
 
-// Contatori atomici per benchmark HE
-static std::atomic<long> total_load_us(0);
-static std::atomic<long> total_add_us(0);
-static std::atomic<long> total_save_us(0);
-static std::atomic<long> he_op_count(0);
+// Aggregazione in-network (attiva solo se agg_window_msgs > 0): finestre condivise tra i lcore
+static AggregationTable* agg_table = nullptr;
+
+// Allocazioni di mbuf fallite (pool vuoto) sommate su tutti i lcore
+static std::atomic<uint64_t> mbuf_alloc_failures(0);
+
+// Steering per message_id (attivo solo se steer_by_message_id): una coda di frammenti per lcore
+static MessageSteering* steering = nullptr;
 
 // simple signal handling, set exit flag
 static void handle_exit_signal(int sig)
@@ -893,16 +1146,10 @@ struct worker_args
     struct worker_conf
     {
         bool used = false;
-        struct
-        {
-            uint16_t port_id = -1;
-            uint16_t queue_id = -1;
-        } ingress;
-        struct
-        {
-            uint16_t port_id = -1;
-            uint16_t queue_id = -1;
-        } egress;
+        // Porte e code servite dal thread
+        ForwardingQueues queues;
+        // Pool usato per i pacchetti generati dal thread stesso (frammenti delle risposte)
+        struct rte_mempool *mbuf_pool = nullptr;
     };
 
     std::vector<worker_conf> confs;
@@ -917,253 +1164,26 @@ static struct worker_args get_worker_args(struct app_005_cfg &cfg)
 {
     worker_args wargs(cfg.dpdk.nb_dpdk_threads);
 
-    for (int cpu = 0; cpu < wargs.confs.size(); ++cpu)
+    for (size_t cpu = 0; cpu < wargs.confs.size(); ++cpu)
     {
-        wargs.confs[cpu].used = (cpu < cfg.dpdk.nb_rxtx_queues);
+        wargs.confs[cpu].used = ((int)cpu < cfg.dpdk.nb_rxtx_queues);
         if (wargs.confs[cpu].used)
         {
             //Ogni thread gestisce la coda col suo stesso id
-            wargs.confs[cpu].ingress.port_id = cfg.dpdk.ingress.port_id;
-            wargs.confs[cpu].egress.port_id = cfg.dpdk.egress.port_id;
-            wargs.confs[cpu].ingress.queue_id = cfg.dpdk.rxtx_queues[cpu];
-            wargs.confs[cpu].egress.queue_id = cfg.dpdk.rxtx_queues[cpu];
+            wargs.confs[cpu].queues.ingress.port_id = cfg.dpdk.ingress.port_id;
+            wargs.confs[cpu].queues.egress.port_id = cfg.dpdk.egress.port_id;
+            wargs.confs[cpu].queues.ingress.queue_id = cfg.dpdk.rxtx_queues[cpu];
+            wargs.confs[cpu].queues.egress.queue_id = cfg.dpdk.rxtx_queues[cpu];
+            // pool del socket NUMA del lcore
+            wargs.confs[cpu].mbuf_pool = cfg.dpdk.mbuf_pools[cfg.dpdk.worker_sockets[cpu]];
         }
     }
 
     return wargs;
 }
 
-// Static senza multi-threading, thread_local con multi-threading (per evitare race condition)
-thread_local PacketAssembler assembler;
-thread_local HEContext* he_ctx = nullptr;  // Inizializzato nel main, per evitare errore all'avvio
-thread_local std::vector<seal::seal_byte> ciphertext_buffer;  // Buffer riutilizzabile per evitare allocazioni
-// poll for input packets from the in_* direction
-// and send them to the out_* direction
-
-// Funzione che viene chiamata continuamente dai vari thread. Ogni iterazione non viene usata
-// sempre più memoria, ma viene riutilizzata la memoria già allocata (NOTA rte_eth_rx_burst non alloca nuova memoria).
-// La RAM usata aumenta solo all'arrivo del primo messaggio (~2MB per thread), e viene poi riusata la stessa
-// all'arrivo dei messaggi successivi.
-// Il programma usa circa 135MB di RAM (diventano ~137MB dopo l'arrivo del primo messaggio).
-inline static doca_error_t poll_interface_and_fwd(
-    uint16_t in_port, uint16_t in_queue,
-    uint16_t out_port, uint16_t out_queue,
-    uint32_t burst_size, struct rte_mbuf ** const &mbufs
-)
-{
-    // Per ogni pacchetto disponibile (fino a BURST_SIZE) nella RX queue (in_queue), prende
-    // un mbuf nel mempool e ne copia il puntatore in mbufs[i]. Gli mbuf sono allocati nel mempool
-    // all'avvio del programma da rte_pktmbuf_pool_create. Ne vengono allocati app_005_cfg::dpdk::mbuf_pool_size (16k),
-    // ognuno di circa 2KB (1 << 11 in app_005_cfg::dpdk::mbuf_pool_pkt_buf_size).
-    uint16_t nb_rx = rte_eth_rx_burst(in_port, in_queue, mbufs, burst_size);
-
-    /*if(nb_rx > 0){
-        printf("[THREAD%d] Ricevuti %u pacchetti\n", rte_lcore_index(rte_lcore_id()), nb_rx);
-    }*/
-
-    for (uint16_t i = 0; i < nb_rx; i++) {
-        struct rte_mbuf *mbuf = mbufs[i];
-        uint8_t *data = rte_pktmbuf_mtod(mbuf, uint8_t *);
-
-        //Ethernet
-        struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
-        if (eth->ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4))
-            continue;
-
-        // IPv4 
-        struct rte_ipv4_hdr *ip = (struct rte_ipv4_hdr *)(eth + 1);
-        if (ip->next_proto_id != IPPROTO_UDP)
-            continue;
-
-        uint16_t ip_hdr_len = (ip->version_ihl & 0x0f) * 4;
-
-        // UDP
-        struct rte_udp_hdr *udp =
-            (struct rte_udp_hdr *)((uint8_t *)ip + ip_hdr_len);
-
-        uint8_t *udp_payload = (uint8_t *)(udp + 1);
-        //lunghezza dei singoli frammenti
-        uint16_t udp_payload_len = rte_be_to_cpu_16(udp->dgram_len) - sizeof(struct rte_udp_hdr); 
-
-        //Non assemblare pacchetti non destinati al receiver (usa costanti da config.h)
-        if(udp->dst_port < rte_cpu_to_be_16(BASE_PORT) || udp->dst_port > rte_cpu_to_be_16(BASE_PORT + N_PORTS - 1)){
-            //printf("[THREAD%d] Pacchetto con porta %u non assemblato\n", rte_lcore_index(rte_lcore_id()), (unsigned)rte_be_to_cpu_16(udp->dst_port));
-            continue;
-        }
-
-        // Devo fare cast da uint8_t a const char per come è scritto packet_assembler (in cui tengo char per semplicità)
-        auto result = assembler.process_packet((const char *)udp_payload, udp_payload_len);
-        if(result.complete){
-            //printf("[THREAD%d] Pacchetto %d assemblato sulla porta %u\n", rte_lcore_index(rte_lcore_id()), result.message_id, rte_be_to_cpu_16(udp->dst_port));
-
-            // Stampa il numero di pacchetti nella coda RX, per capire se raggiunge effettivamente il limite
-            uint32_t queue_count = rte_eth_rx_queue_count(in_port, in_queue);
-            //printf("[THREAD%d] Numero di pacchetti nella RX queue: %u\n", rte_lcore_index(rte_lcore_id()), queue_count);
-            auto start = std::chrono::high_resolution_clock::now(); // Timer iniziale per benchmark
-            
-            // Si ricrea oggetto SEAL partendo dal buffer 
-            Ciphertext ct;
-            // Faccio casting in quanto result.data.data è di tipo char
-            ct.load(*he_ctx->context, 
-                    reinterpret_cast<const seal::seal_byte*>(result.data.data()), 
-                    result.data.size());
-            auto after_load = std::chrono::high_resolution_clock::now();
-
-            // std::chrono::duration_cast<std::chrono::microseconds> restituisce un oggetto di tipo std::chrono::microseconds
-            // Facendo .count() ne prendo i microsecondi
-            auto load_us = std::chrono::duration_cast<std::chrono::microseconds>(after_load - start).count();
-            
-            // Somma omomorfica con una costante
-            he_ctx->add_plain_number(ct, 13291);
-            auto after_add = std::chrono::high_resolution_clock::now();
-            auto add_us = std::chrono::duration_cast<std::chrono::microseconds>(after_add - after_load).count();
-            
-            // Si prepara il buffer da inviare (senza compressione per risparmiare CPU, pesa solo 2 KB in più)
-            auto ct_size = ct.save_size(seal::compr_mode_type::none);
-            ciphertext_buffer.resize(ct_size);
-            ct.save(ciphertext_buffer.data(), ciphertext_buffer.size(), seal::compr_mode_type::none);  
-
-            auto after_save = std::chrono::high_resolution_clock::now();
-            auto save_us = std::chrono::duration_cast<std::chrono::microseconds>(after_save - after_add).count();
-            
-            //printf("HE load:%ld add:%ld save:%ld \n", load_us, add_us, save_us);
-            
-            if (result.message_id > LOWER_BOUND) {
-                total_load_us.fetch_add(load_us);
-                total_add_us.fetch_add(add_us);
-                total_save_us.fetch_add(save_us);
-                he_op_count.fetch_add(1);
-            }
-            //printf("[THREAD%d] Ciphertext risultante: %zu bytes\n", rte_lcore_index(rte_lcore_id()), ciphertext_str.size());
-            
-            // Frammentazione e invio indietro
-            // Non uso la classe Message in quanto essa è fatta per l'invio con uso di socket
-            uint32_t total_size = ciphertext_buffer.size();
-            uint16_t total_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
-            //printf("[THREAD%d] Frammentazione in %u chunks\n", rte_lcore_index(rte_lcore_id()), total_chunks);
-            
-            // Configuro gli indirizzi che verranno usati per inviare i singoli frammenti
-
-            /*Non vanno modificati: nel mio test la DPU1 invia un pacchetto dal nsp0 
-            al nsp1, il quale viene intercettato dalla DPU2. Gli indirizzi di destinazione,
-            perciò, puntano già al nsp1 della DPU1! CAMBIO PERO' LA PORTA DI DESTINAZIONE UDP!*/
-            struct rte_ether_addr src_mac = eth->src_addr;
-            struct rte_ether_addr dst_mac = eth->dst_addr;
-            
-            uint32_t src_ip = ip->src_addr;  // IP sorgente fisso (nsp1, il sender originale)
-            uint32_t dst_ip = ip->dst_addr;  // IP di destinazione del pacchetto originale (nsp0 = 192.168.28.10)
-            
-            uint16_t src_port = udp->src_port;
-            /*Potrei lasciarla invariata, ma ho visto che se lo faccio il receiver
-            intercetta i messaggi inviati dalla DPU1 prima che la DPU2 li elabori*/
-            uint16_t dst_port = rte_cpu_to_be_16(RX_PORT);
-            
-            // Alloca tutti gli mbuf in una volta (bulk alloc), per evitare di allocare mbuf per ogni chunk ad ogni iterazione
-            struct rte_mbuf *response_mbufs[total_chunks];
-            if (rte_pktmbuf_alloc_bulk(mbuf->pool, response_mbufs, total_chunks) != 0) {
-                printf("[THREAD%d] Errore bulk alloc per i mbufs\n", rte_lcore_index(rte_lcore_id()));
-                continue;
-            }
-            
-            // Preparo il telemetry header (si trova in message.h)
-            TelemetryHeader tel_hdr;
-            tel_hdr.message_id = result.message_id;
-            tel_hdr.total_chunks = total_chunks;
-            tel_hdr.ciphertext_total_size = total_size;
-            
-            // Invia ogni chunk
-            for (uint16_t chunk_idx = 0; chunk_idx < total_chunks; chunk_idx++) {
-                // Calcola dimensione del chunk corrente
-                uint32_t offset = chunk_idx * CHUNK_SIZE;
-                uint16_t current_chunk_size = std::min((uint32_t)CHUNK_SIZE, total_size - offset);
-                
-                struct rte_mbuf *response_mbuf = response_mbufs[chunk_idx];
-                
-                tel_hdr.chunk_index = chunk_idx;
-                tel_hdr.chunk_size = current_chunk_size;
-                
-                // Calcolo dimensioni
-                uint16_t payload_size = sizeof(TelemetryHeader) + current_chunk_size;
-                uint16_t total_pkt_size = sizeof(struct rte_ether_hdr) + 
-                                         sizeof(struct rte_ipv4_hdr) + 
-                                         sizeof(struct rte_udp_hdr) + 
-                                         payload_size;
-                
-                // Costruisco il pacchetto
-                uint8_t *pkt_data = rte_pktmbuf_mtod(response_mbuf, uint8_t *);
-                //Ogni header viene scritto nel buffer partendo dall'offset 0
-                // Ethernet header
-                struct rte_ether_hdr *eth_hdr = (struct rte_ether_hdr *)pkt_data;
-                eth_hdr->src_addr = src_mac;
-                eth_hdr->dst_addr = dst_mac;
-                eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4); //Dice che il payload ethernet contiene un pacchetto IPv4
-                
-                // IP header
-                struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1); //Scorro nel buffer pkt_data...
-                memset(ip_hdr, 0, sizeof(struct rte_ipv4_hdr));
-                ip_hdr->version_ihl = 0x45;  // IPv4
-                ip_hdr->type_of_service = 0;
-                ip_hdr->total_length = rte_cpu_to_be_16(sizeof(struct rte_ipv4_hdr) + 
-                                                        sizeof(struct rte_udp_hdr) + 
-                                                        payload_size);
-                ip_hdr->packet_id = 0;  //Non uso la frammentazione a livello IP
-                ip_hdr->fragment_offset = 0;
-                ip_hdr->time_to_live = 64; //Standard
-                ip_hdr->next_proto_id = IPPROTO_UDP;
-                ip_hdr->src_addr = src_ip;
-                ip_hdr->dst_addr = dst_ip;
-                ip_hdr->hdr_checksum = 0;
-                ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);
-                
-                // UDP header
-                struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)(ip_hdr + 1);
-                udp_hdr->src_port = src_port;
-                udp_hdr->dst_port = dst_port;
-                udp_hdr->dgram_len = rte_cpu_to_be_16(sizeof(struct rte_udp_hdr) + payload_size);
-                udp_hdr->dgram_cksum = 0;  // Opzionale per UDP
-                
-                // Payload: header telemetria + chunk dati (Come in message.cpp)
-                uint8_t *payload = (uint8_t *)(udp_hdr + 1);
-                memcpy(payload, &tel_hdr, sizeof(TelemetryHeader));
-                memcpy(payload + sizeof(TelemetryHeader), 
-                       ciphertext_buffer.data() + offset, 
-                       current_chunk_size);
-                
-                // Imposta lunghezza pacchetto
-                response_mbuf->data_len = total_pkt_size; //Lunghezza dati in questo mbuf
-                response_mbuf->pkt_len = total_pkt_size; //Lunghezza pacchetto (che può essere distribuito su più mbuf)
-                
-                // Invia il pacchetto sulla porta di USCITA (out_port = P1)
-                // Il pacchetto arriva su P0, viene elaborato, e esce su P1 verso DPU1:P1
-                uint16_t sent = rte_eth_tx_burst(out_port, out_queue, &response_mbuf, 1);
-                if (sent == 0) {
-                    printf("[THREAD%d] Errore invio chunk %u\n", rte_lcore_index(rte_lcore_id()), chunk_idx);
-                    rte_pktmbuf_free(response_mbuf);
-                }
-            }
-            
-            //printf("[THREAD%d] Tutti i %u chunks inviati\n", rte_lcore_index(rte_lcore_id()), total_chunks);
-        }
-        
-        //rte_eth_tx_burst dovrebbe occuparsi di liberare la memoria allocata per il mbuf
-
-    }
-
-    // Forward packets 
-    uint16_t sent = 0;
-    while (sent < nb_rx)
-        sent += rte_eth_tx_burst(
-            out_port, out_queue, &mbufs[sent], nb_rx - sent);
-
-    return DOCA_SUCCESS;
-}
-
-
 static int my_dpdk_worker(void *my_dpdk_worker_arg)
 {
-    struct rte_mbuf *mbufs[BURST_SIZE] = {};
-    doca_error_t result;
-
     if (!my_dpdk_worker_arg)
     {
         std::cerr << "my_dpdk_worker::my_dpdk_worker = " << my_dpdk_worker_arg  << std::endl;
@@ -1186,31 +1206,15 @@ static int my_dpdk_worker(void *my_dpdk_worker_arg)
         return 0;
     }
 
-    // Inizializzazione del contesto SEAL per ogni thread separato
-    he_ctx = new HEContext();
+    // Il datapath (riassemblaggio, HE, frammentazione) è in forwarder.cpp, uguale per tutti i backend.
+    // Forwarder va creato qui: il contesto SEAL e il suo pool di memoria appartengono a questo lcore
+    DpdkPacketIO io(thread_args.mbuf_pool);
+    Forwarder fwd(io, agg_table, steering, worker_id);
 
     // loop until exit is requested!
-    while (!exit_request.load())
-    {
-        /* from ingress to egress */
-        // Chiamata continuamente anche quando non arriva niente ==> consumo CPU massimo
-        result = poll_interface_and_fwd(
-            thread_args.ingress.port_id, thread_args.ingress.queue_id,
-            thread_args.egress.port_id, thread_args.egress.queue_id,
-            BURST_SIZE, mbufs
-        );
-        CHECK_DERR(result);
-        /* from egress to ingress */
-        result = poll_interface_and_fwd(
-            thread_args.egress.port_id, thread_args.egress.queue_id,
-            thread_args.ingress.port_id, thread_args.ingress.queue_id,
-            BURST_SIZE, mbufs
-        );
-        CHECK_DERR(result);
-    }
+    run_forwarding_loop(fwd, thread_args.queues, runtime_config().burst_size, exit_request);
 
-    delete he_ctx;
-    he_ctx = nullptr;
+    mbuf_alloc_failures.fetch_add(io.get_alloc_failures());
 
     return 0;
 }
@@ -1234,6 +1238,29 @@ int main(int argc, char *argv[])
     result = doca_argp_start(argc, argv);
     CHECK_DERR(result);
 
+    // Contesto SEAL costruito una volta sola, prima dei lcore: gli HEContext lo condividono
+    if (!init_seal_context(runtime_config()) || !validate_config(runtime_config()))
+    {
+        doca_argp_destroy();
+        return EXIT_FAILURE;
+    }
+    // Con il power management del PMD le code vuote sospendono già il lcore. Il PMD guarda solo le code
+    // RX della NIC: code di steering, backlog dei tenant e timer delle finestre di aggregazione
+    // resterebbero fermi fino al pacchetto successivo, quindi non si possono combinare
+    if (cfg.dpdk.power_mgmt)
+    {
+        const RuntimeConfig &rcfg = runtime_config();
+        if (rcfg.steer_by_message_id || rcfg.tenant_scheduling || rcfg.agg_window_msgs > 0)
+        {
+            std::cerr << "power-mgmt non è compatibile con steer-by-message-id, tenant-scheduling e "
+                         "aggregazione (agg-window-msgs > 0)" << std::endl;
+            doca_argp_destroy();
+            return EXIT_FAILURE;
+        }
+        runtime_config().idle_backoff = false;
+    }
+    print_config(runtime_config());
+
     // Configure DPDK ports and queues:
     //  DOCA Flow is based on DPDK
     result = configure_dpdk_ports_and_queues(cfg.dpdk);
@@ -1248,11 +1275,39 @@ int main(int argc, char *argv[])
 
     auto w_args = get_worker_args(cfg);
 
+    // Aggregazione in-network: finestre condivise tra tutti i lcore
+    const RuntimeConfig &rcfg = runtime_config();
+    if (rcfg.agg_window_msgs > 0) {
+        agg_table = new AggregationTable(rcfg.agg_window_msgs, std::chrono::milliseconds(rcfg.agg_window_ms));
+        std::cout << "Aggregazione attiva: " << rcfg.agg_window_msgs << " messaggi o "
+                  << rcfg.agg_window_ms << " ms per finestra" << std::endl;
+    }
+
+    // L'RSS della pipe di ingresso distribuisce per indirizzi e porte UDP: con lo steering ogni messaggio
+    // viene riassemblato dal lcore proprietario, qualunque sia la coda su cui arrivano i frammenti
+    if (rcfg.steer_by_message_id) {
+        steering = new MessageSteering(cfg.dpdk.nb_rxtx_queues, rcfg.steer_ring_size);
+        std::cout << "Steering per message_id su " << cfg.dpdk.nb_rxtx_queues << " lcore" << std::endl;
+    }
+
     // set signal handler (nothing to do,
     // just avoiding crash)
     signal(SIGINT, handle_exit_signal);
     signal(SIGTERM, handle_exit_signal);
 
+    // Statistiche per lcore: socket di telemetria DPDK
+    // ("/forwarder/stats") e riga periodica opzionale
+    set_stats_lcore_count(rte_lcore_count());
+    if (register_stats_telemetry() < 0)
+    {
+        std::cerr << "register_stats_telemetry failed" << std::endl;
+    }
+    std::thread stats_thread;
+    if (rcfg.stats_interval_ms > 0)
+    {
+        stats_thread = start_stats_reporter(rcfg.stats_interval_ms, exit_request);
+    }
+
     std::cout << "Press CTRL+C to interrupt!" << std::endl;
 
     // launch DPDK workers
@@ -1265,18 +1320,28 @@ int main(int argc, char *argv[])
     // Wait for workers terminating the function
     // provided by rte_eal_mp_remote_launch
     rte_eal_mp_wait_lcore();
+    if (stats_thread.joinable())
+    {
+        stats_thread.join();
+    }
 
     std::cout << "Shutdown..." << std::endl;
+
+    delete agg_table;
+    agg_table = nullptr;
+    if (steering && steering->get_dropped() > 0)
+        std::cout << "Frammenti persi per code di steering piene: " << steering->get_dropped() << std::endl;
+    delete steering;
+    steering = nullptr;
     
     // Stampa medie benchmark 
-    long count = he_op_count.load();
-    if (count > 0) {
-        std::cout << "Operazioni totali: " << count << std::endl;
-        std::cout << "Media load:  " << (total_load_us.load() / count) << " µs" << std::endl;
-        std::cout << "Media add:   " << (total_add_us.load() / count) << " µs" << std::endl;
-        std::cout << "Media save:  " << (total_save_us.load() / count) << " µs" << std::endl;
-        std::cout << "Media totale: " << ((total_load_us.load() + total_add_us.load() + total_save_us.load()) / count) << " µs" << std::endl;
-    }
+    print_he_benchmark();
+    print_stats_summary();
+    print_tenant_stats();
+
+    // Utilizzo dei mempool e allocazioni fallite (pool esaurito sotto carico)
+    print_mbuf_pool_usage(cfg.dpdk);
+    std::cout << "mbuf alloc failures: " << mbuf_alloc_failures.load() << std::endl;
 
     result = cleanup_doca(cfg);
     CHECK_DERR(result);
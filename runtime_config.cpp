@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "runtime_config.h"
+#include "packet_io.h"
+
+RuntimeConfig &runtime_config() {
+    static RuntimeConfig cfg;
+    return cfg;
+}
+
+// Converte value in un intero senza segno nei limiti di T
+template <typename T>
+static bool parse_unsigned(const std::string &value, T &out) {
+    if (value.empty() || value[0] == '-')
+        return false;
+    errno = 0;
+    char *end = nullptr;
+    unsigned long long v = strtoull(value.c_str(), &end, 0);
+    if (errno != 0 || *end != '\0' || v > std::numeric_limits<T>::max())
+        return false;
+    out = static_cast<T>(v);
+    return true;
+}
+
+static bool parse_bool(const std::string &value, bool &out) {
+    if (value == "1" || value == "true" || value == "yes" || value == "on") {
+        out = true;
+        return true;
+    }
+    if (value == "0" || value == "false" || value == "no" || value == "off") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_value(const std::string &value, TrafficVerdict &out) {
+    if (value == "consume")
+        out = TrafficVerdict::Consume;
+    else if (value == "forward")
+        out = TrafficVerdict::Forward;
+    else if (value == "drop")
+        out = TrafficVerdict::Drop;
+    else
+        return false;
+    return true;
+}
+
+static bool parse_value(const std::string &value, bool &out) {
+    return parse_bool(value, out);
+}
+
+template <typename T>
+static bool parse_value(const std::string &value, T &out) {
+    return parse_unsigned(value, out);
+}
+
+// Come si imposta ogni parametro: stesso ordine di CONFIG_OPTIONS (controllato a compile time), così
+// un parametro non può essere accettato da set_config_option e mancare dalle opzioni o viceversa
+struct ConfigSetter {
+    const char *name;
+    bool (*set)(RuntimeConfig &cfg, const std::string &value);
+};
+
+#define CONFIG_SETTER(name, field) \
+    {name, [](RuntimeConfig &cfg, const std::string &value) { return parse_value(value, cfg.field); }}
+
+static constexpr ConfigSetter CONFIG_SETTERS[] = {
+    CONFIG_SETTER("poly-modulus-degree", poly_modulus_degree),
+    CONFIG_SETTER("plain-modulus", plain_modulus),
+    CONFIG_SETTER("base-port", base_port),
+    CONFIG_SETTER("n-ports", n_ports),
+    CONFIG_SETTER("rx-port", rx_port),
+    CONFIG_SETTER("lower-bound", lower_bound),
+    CONFIG_SETTER("rx-queue-size", rx_queue_size),
+    CONFIG_SETTER("tx-queue-size", tx_queue_size),
+    CONFIG_SETTER("burst-size", burst_size),
+    CONFIG_SETTER("agg-window-msgs", agg_window_msgs),
+    CONFIG_SETTER("agg-window-ms", agg_window_ms),
+    CONFIG_SETTER("slot-sum-group", slot_sum_group),
+    CONFIG_SETTER("cut-through", cut_through),
+    CONFIG_SETTER("stream-timeout-ms", stream_timeout_ms),
+    CONFIG_SETTER("steer-by-message-id", steer_by_message_id),
+    CONFIG_SETTER("steer-ring-size", steer_ring_size),
+    CONFIG_SETTER("adaptive-burst", adaptive_burst),
+    CONFIG_SETTER("burst-min", burst_min),
+    CONFIG_SETTER("poll-weight-ingress", poll_weight_ingress),
+    CONFIG_SETTER("poll-weight-egress", poll_weight_egress),
+    CONFIG_SETTER("idle-backoff", idle_backoff),
+    CONFIG_SETTER("idle-spin-polls", idle_spin_polls),
+    CONFIG_SETTER("idle-sleep-us", idle_sleep_us),
+    CONFIG_SETTER("stats-interval-ms", stats_interval_ms),
+    CONFIG_SETTER("admission-watermark", admission_watermark),
+    CONFIG_SETTER("admission-forward", admission_forward),
+    CONFIG_SETTER("verdict-telemetry", verdict_telemetry),
+    CONFIG_SETTER("verdict-other", verdict_other),
+    CONFIG_SETTER("tenant-scheduling", tenant_scheduling),
+    CONFIG_SETTER("tenant-by-port", tenant_by_port),
+    CONFIG_SETTER("tenant-quantum", tenant_quantum),
+    CONFIG_SETTER("tenant-queue-len", tenant_queue_len),
+    CONFIG_SETTER("tenant-rate-limit", tenant_rate_limit),
+    CONFIG_SETTER("tenant-burst", tenant_burst),
+    CONFIG_SETTER("tenant-max", tenant_max),
+    CONFIG_SETTER("tenant-he-budget", tenant_he_budget),
+    CONFIG_SETTER("decrypt-workers", decrypt_workers),
+    CONFIG_SETTER("decrypt-queue-size", decrypt_queue_size),
+    CONFIG_SETTER("batch-flush-timeout-us", batch_flush_timeout_us),
+};
+
+#undef CONFIG_SETTER
+
+static constexpr bool same_name(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static constexpr bool setters_match_options() {
+    if (sizeof(CONFIG_SETTERS) / sizeof(CONFIG_SETTERS[0]) != N_CONFIG_OPTIONS)
+        return false;
+    for (size_t i = 0; i < N_CONFIG_OPTIONS; i++) {
+        if (!same_name(CONFIG_SETTERS[i].name, CONFIG_OPTIONS[i].name))
+            return false;
+    }
+    return true;
+}
+
+static_assert(setters_match_options(), "CONFIG_SETTERS e CONFIG_OPTIONS devono avere gli stessi parametri nello stesso ordine");
+
+bool set_config_option(RuntimeConfig &cfg, const std::string &name, const std::string &value) {
+    std::string key = name;
+    std::replace(key.begin(), key.end(), '_', '-');
+
+    for (const auto &setter : CONFIG_SETTERS) {
+        if (key != setter.name)
+            continue;
+        bool ok = setter.set(cfg, value);
+        if (!ok)
+            std::cerr << "Valore non valido per " << name << ": " << value << std::endl;
+        return ok;
+    }
+
+    std::cerr << "Parametro sconosciuto: " << name << std::endl;
+    return false;
+}
+
+// Rimuove gli spazi all'inizio e alla fine
+static std::string trim(const std::string &s) {
+    const char *ws = " \t\r";
+    size_t begin = s.find_first_not_of(ws);
+    if (begin == std::string::npos)
+        return "";
+    return s.substr(begin, s.find_last_not_of(ws) + 1 - begin);
+}
+
+bool load_config_file(RuntimeConfig &cfg, const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "File di configurazione non trovato: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << path << ":" << line_no << ": manca '='" << std::endl;
+            return false;
+        }
+        if (!set_config_option(cfg, trim(line.substr(0, eq)), trim(line.substr(eq + 1))))
+            return false;
+    }
+    return true;
+}
+
+// Vero se name (senza "--") è un parametro di CONFIG_OPTIONS
+static bool is_config_option(std::string name) {
+    std::replace(name.begin(), name.end(), '_', '-');
+    for (const auto &opt : CONFIG_OPTIONS) {
+        if (name == opt.name)
+            return true;
+    }
+    return false;
+}
+
+bool parse_config_args(RuntimeConfig &cfg, int &argc, char *argv[]) {
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        // "--" separa le opzioni di altri parser (EAL, DOCA): da qui in poi non tocco niente
+        if (arg == "--") {
+            while (i < argc)
+                argv[out++] = argv[i++];
+            break;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            argv[out++] = argv[i];
+            continue;
+        }
+
+        std::string name = arg.substr(2);
+        std::string value;
+        bool inline_value = false;
+        size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            value = name.substr(eq + 1);
+            name = name.substr(0, eq);
+            inline_value = true;
+        }
+
+        if (name != "config" && !is_config_option(name)) {
+            // Opzione del programma (es. --symmetric del sender)
+            argv[out++] = argv[i];
+            continue;
+        }
+
+        if (!inline_value) {
+            if (i + 1 >= argc) {
+                std::cerr << "Manca il valore di --" << name << std::endl;
+                return false;
+            }
+            value = argv[++i];
+        }
+
+        bool ok = (name == "config") ? load_config_file(cfg, value) : set_config_option(cfg, name, value);
+        if (!ok)
+            return false;
+    }
+    argc = out;
+    argv[argc] = nullptr;
+    return validate_config(cfg);
+}
+
+bool validate_config(const RuntimeConfig &cfg) {
+    bool ok = true;
+    if (cfg.poly_modulus_degree < 1024 || (cfg.poly_modulus_degree & (cfg.poly_modulus_degree - 1)) != 0) {
+        std::cerr << "poly-modulus-degree deve essere una potenza di 2 >= 1024" << std::endl;
+        ok = false;
+    }
+    // Un gruppo di 1 slot non somma nulla: si accettano solo 0 (disattivato) o gruppi da almeno 2
+    if (cfg.slot_sum_group == 1 || cfg.slot_sum_group > cfg.poly_modulus_degree ||
+        (cfg.slot_sum_group & (cfg.slot_sum_group - 1)) != 0) {
+        std::cerr << "slot-sum-group deve essere 0 oppure una potenza di 2 compresa tra 2 e poly-modulus-degree" << std::endl;
+        ok = false;
+    }
+    if (cfg.stream_timeout_ms == 0) {
+        std::cerr << "stream-timeout-ms deve essere > 0" << std::endl;
+        ok = false;
+    }
+    if (cfg.n_ports == 0 || cfg.base_port + cfg.n_ports - 1 > 65535) {
+        std::cerr << "Intervallo di porte non valido" << std::endl;
+        ok = false;
+    }
+    if (cfg.burst_size == 0 || cfg.burst_size > PACKET_IO_MAX_BURST) {
+        std::cerr << "burst-size deve essere compreso tra 1 e " << PACKET_IO_MAX_BURST << std::endl;
+        ok = false;
+    }
+    if (cfg.burst_min == 0 || cfg.burst_min > cfg.burst_size) {
+        std::cerr << "burst-min deve essere compreso tra 1 e burst-size" << std::endl;
+        ok = false;
+    }
+    if (cfg.poll_weight_ingress == 0 || cfg.poll_weight_egress == 0) {
+        std::cerr << "I pesi del polling devono essere > 0" << std::endl;
+        ok = false;
+    }
+    if (cfg.tenant_quantum == 0 || cfg.tenant_queue_len == 0 || cfg.tenant_burst == 0 ||
+        cfg.tenant_max == 0 || cfg.tenant_he_budget == 0) {
+        std::cerr << "tenant-quantum, tenant-queue-len, tenant-burst, tenant-max e tenant-he-budget devono essere > 0" << std::endl;
+        ok = false;
+    }
+    if (cfg.decrypt_workers == 0 || cfg.decrypt_queue_size == 0) {
+        std::cerr << "decrypt-workers e decrypt-queue-size devono essere > 0" << std::endl;
+        ok = false;
+    }
+    if (cfg.rx_queue_size == 0 || cfg.tx_queue_size == 0) {
+        std::cerr << "Le dimensioni delle code devono essere > 0" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+void print_config(const RuntimeConfig &cfg) {
+    std::cout << "Configurazione: grado " << cfg.poly_modulus_degree << ", plain modulus " << cfg.plain_modulus
+              << ", porte " << cfg.base_port << "-" << (cfg.base_port + cfg.n_ports - 1)
+              << ", rx port " << cfg.rx_port << ", code " << cfg.rx_queue_size << "/" << cfg.tx_queue_size
+              << ", burst " << cfg.burst_size;
+    if (cfg.adaptive_burst)
+        std::cout << " (adattivo da " << cfg.burst_min << ")";
+    std::cout << ", pesi ingress/egress " << cfg.poll_weight_ingress << "/" << cfg.poll_weight_egress;
+    if (cfg.tenant_scheduling) {
+        std::cout << ", tenant per IP" << (cfg.tenant_by_port ? " e porta" : "") << " (quantum " << cfg.tenant_quantum
+                  << " byte, coda " << cfg.tenant_queue_len << ", " << cfg.tenant_he_budget << " msg per giro";
+        if (cfg.tenant_rate_limit > 0)
+            std::cout << ", max " << cfg.tenant_rate_limit << " msg/s";
+        std::cout << ")";
+    }
+    std::cout << std::endl;
+}
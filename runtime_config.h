@@ -0,0 +1,133 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "config.h"
+
+// Parametri modificabili senza ricompilare, da file di configurazione o da linea di comando.
+// I valori di default sono le costanti di config.h, che restano i valori per cui il codice è
+// specializzato a compile time (es. HEContext::add_plain_number_fast per i gradi più comuni)
+struct RuntimeConfig {
+    // Parametri SEAL
+    size_t poly_modulus_degree = POLY_MODULUS_DEGREE;
+    uint64_t plain_modulus = PLAIN_MODULUS;
+
+    // Parametri di rete
+    uint16_t base_port = BASE_PORT;
+    uint16_t n_ports = N_PORTS;
+    uint16_t rx_port = RX_PORT;
+    uint64_t lower_bound = LOWER_BOUND;
+    uint16_t rx_queue_size = RX_QUEUE_SIZE;
+    uint16_t tx_queue_size = TX_QUEUE_SIZE;
+    uint32_t burst_size = BURST_SIZE;
+
+    // Forwarder
+    uint32_t agg_window_msgs = AGG_WINDOW_MSGS;
+    uint32_t agg_window_ms = AGG_WINDOW_MS;
+    uint32_t slot_sum_group = SLOT_SUM_GROUP;
+    bool cut_through = CUT_THROUGH;
+    uint32_t stream_timeout_ms = STREAM_TIMEOUT_MS;
+    bool steer_by_message_id = STEER_BY_MESSAGE_ID;
+    uint32_t steer_ring_size = STEER_RING_SIZE;
+    bool adaptive_burst = ADAPTIVE_BURST;
+    uint32_t burst_min = BURST_MIN;
+    uint32_t poll_weight_ingress = POLL_WEIGHT_INGRESS;
+    uint32_t poll_weight_egress = POLL_WEIGHT_EGRESS;
+    bool idle_backoff = IDLE_BACKOFF;
+    uint32_t idle_spin_polls = IDLE_SPIN_POLLS;
+    uint32_t idle_sleep_us = IDLE_SLEEP_US;
+    uint32_t stats_interval_ms = STATS_INTERVAL_MS;
+    uint32_t admission_watermark = ADMISSION_WATERMARK;
+    bool admission_forward = ADMISSION_FORWARD;
+    TrafficVerdict verdict_telemetry = VERDICT_TELEMETRY;
+    TrafficVerdict verdict_other = VERDICT_OTHER;
+    bool tenant_scheduling = TENANT_SCHEDULING;
+    bool tenant_by_port = TENANT_BY_PORT;
+    uint32_t tenant_quantum = TENANT_QUANTUM;
+    uint32_t tenant_queue_len = TENANT_QUEUE_LEN;
+    uint32_t tenant_rate_limit = TENANT_RATE_LIMIT;
+    uint32_t tenant_burst = TENANT_BURST;
+    uint32_t tenant_max = TENANT_MAX;
+    uint32_t tenant_he_budget = TENANT_HE_BUDGET;
+
+    // Receiver
+    uint32_t decrypt_workers = DECRYPT_WORKERS;
+    uint32_t decrypt_queue_size = DECRYPT_QUEUE_SIZE;
+
+    // Sender
+    uint32_t batch_flush_timeout_us = BATCH_FLUSH_TIMEOUT_US;
+};
+
+// Nome (come opzione: --nome valore, oppure nome = valore nel file) e descrizione di ogni parametro
+struct ConfigOption {
+    const char *name;
+    const char *description;
+};
+
+constexpr ConfigOption CONFIG_OPTIONS[] = {
+    {"poly-modulus-degree", "grado del polinomio SEAL (potenza di 2)"},
+    {"plain-modulus", "modulo del testo in chiaro SEAL (primo, 1 mod 2*grado per il batching)"},
+    {"base-port", "prima porta UDP della telemetria"},
+    {"n-ports", "numero di porte UDP della telemetria (e di thread del sender)"},
+    {"rx-port", "porta UDP del receiver"},
+    {"lower-bound", "message_id dopo il quale si calcolano i benchmark"},
+    {"rx-queue-size", "descrittori di ogni coda RX"},
+    {"tx-queue-size", "descrittori di ogni coda TX"},
+    {"burst-size", "pacchetti presi al massimo in un burst"},
+    {"agg-window-msgs", "messaggi sommati per finestra di aggregazione (0 = disattivata)"},
+    {"agg-window-ms", "timeout di una finestra di aggregazione incompleta"},
+    {"slot-sum-group", "slot consecutivi sommati nel primo slot del gruppo, potenza di 2 (0 = disattivata)"},
+    {"cut-through", "inoltra i frammenti appena arrivano correggendo sul posto il ciphertext, senza riassemblarlo (0/1)"},
+    {"stream-timeout-ms", "cut-through: ms dopo i quali un messaggio incompleto viene scartato"},
+    {"steer-by-message-id", "steering dei frammenti per message_id (0/1)"},
+    {"steer-ring-size", "frammenti in attesa per lcore con lo steering"},
+    {"adaptive-burst", "burst adattato al carico tra burst-min e burst-size (0/1)"},
+    {"burst-min", "burst minimo con adaptive-burst"},
+    {"poll-weight-ingress", "poll dell'ingress per giro del ciclo di polling"},
+    {"poll-weight-egress", "poll dell'egress per giro del ciclo di polling"},
+    {"idle-backoff", "pausa della CPU quando le code sono vuote (0/1)"},
+    {"idle-spin-polls", "giri a vuoto prima delle pause"},
+    {"idle-sleep-us", "sleep massimo quando le code restano vuote (0 = solo pause della CPU)"},
+    {"stats-interval-ms", "intervallo della riga di statistiche (0 = disattivata)"},
+    {"admission-watermark", "descrittori pieni nella coda RX oltre i quali si rifiutano i messaggi nuovi (0 = mai)"},
+    {"admission-forward", "inoltra senza elaborarli i messaggi rifiutati invece di scartarli (0/1)"},
+    {"verdict-telemetry", "destino dei frammenti di telemetria: consume, forward (elaborati e inoltrati) o drop"},
+    {"verdict-other", "destino del traffico che non è telemetria: forward, drop o consume (= drop)"},
+    {"tenant-scheduling", "code per tenant dei messaggi riassemblati servite con deficit round robin (0/1)"},
+    {"tenant-by-port", "il tenant è IP e porta sorgente invece del solo IP (0/1)"},
+    {"tenant-quantum", "byte aggiunti al deficit di un tenant ad ogni turno"},
+    {"tenant-queue-len", "messaggi in coda per tenant (oltre vengono scartati)"},
+    {"tenant-rate-limit", "messaggi/s per tenant (0 = nessun limite)"},
+    {"tenant-burst", "messaggi accettati di fila oltre il rate di un tenant"},
+    {"tenant-max", "tenant per lcore (i successivi condividono una coda)"},
+    {"tenant-he-budget", "messaggi elaborati dalle code dei tenant per giro del ciclo di polling"},
+    {"decrypt-workers", "thread di decifratura del receiver"},
+    {"decrypt-queue-size", "messaggi completi in attesa di decifratura nel receiver"},
+    {"batch-flush-timeout-us", "timeout del batch incompleto nel sender"},
+};
+
+constexpr size_t N_CONFIG_OPTIONS = sizeof(CONFIG_OPTIONS) / sizeof(CONFIG_OPTIONS[0]);
+
+// Configurazione globale del processo: va modificata solo all'avvio, prima di creare i thread
+RuntimeConfig &runtime_config();
+
+// Imposta un parametro (il nome può usare '-' o '_'). Ritorna false se il nome è sconosciuto o
+// il valore non è valido, con un messaggio su stderr
+bool set_config_option(RuntimeConfig &cfg, const std::string &name, const std::string &value);
+
+// Legge un file con righe "nome = valore" ('#' inizia un commento)
+bool load_config_file(RuntimeConfig &cfg, const std::string &path);
+
+// Consuma da argv le opzioni --config <file>, --<nome> <valore> e --<nome>=<valore>, lasciando
+// gli altri argomenti (nello stesso ordine) per il parsing del programma. Ritorna false in caso di errore
+bool parse_config_args(RuntimeConfig &cfg, int &argc, char *argv[]);
+
+// Controlla la coerenza dei parametri (es. burst_size <= PACKET_IO_MAX_BURST)
+bool validate_config(const RuntimeConfig &cfg);
+
+void print_config(const RuntimeConfig &cfg);
+
+#endif
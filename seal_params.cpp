@@ -0,0 +1,144 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include "seal_params.h"
+
+using namespace seal;
+
+static std::mutex context_mtx;
+static std::shared_ptr<const SEALContext> shared_context;   // Protetto da context_mtx
+
+// Chiavi di valutazione, caricate al primo uso (protette da keys_mtx)
+static std::mutex keys_mtx;
+static bool relin_loaded = false;
+static bool galois_loaded = false;
+static std::shared_ptr<const RelinKeys> shared_relin_keys;
+static std::shared_ptr<const GaloisKeys> shared_galois_keys;
+
+EncryptionParameters make_encryption_parameters(const RuntimeConfig &cfg)
+{
+    EncryptionParameters parms(scheme_type::bfv);
+    parms.set_poly_modulus_degree(cfg.poly_modulus_degree);
+    parms.set_coeff_modulus(CoeffModulus::BFVDefault(cfg.poly_modulus_degree));
+    parms.set_plain_modulus(cfg.plain_modulus);
+    return parms;
+}
+
+bool save_encryption_parameters(const EncryptionParameters &parms, const char *path)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossibile creare " << path << std::endl;
+        return false;
+    }
+    parms.save(file);
+    return (bool)file;
+}
+
+static bool build_context(const EncryptionParameters &parms)
+{
+    auto context = std::make_shared<const SEALContext>(parms);
+    if (!context->parameters_set()) {
+        std::cerr << "Parametri SEAL non validi" << std::endl;
+        return false;
+    }
+    shared_context = context;
+    return true;
+}
+
+bool init_seal_context(RuntimeConfig &cfg)
+{
+    std::lock_guard<std::mutex> lock(context_mtx);
+
+    std::ifstream file(PARMS_FILE, std::ios::binary);
+    if (!file) {
+        std::cerr << PARMS_FILE << " non trovato: parametri SEAL dalla configurazione" << std::endl;
+        return build_context(make_encryption_parameters(cfg));
+    }
+
+    EncryptionParameters parms;
+    try {
+        parms.load(file);
+    } catch (const std::exception &e) {
+        std::cerr << PARMS_FILE << " non valido: " << e.what() << std::endl;
+        return false;
+    }
+    if (parms.scheme() != scheme_type::bfv) {
+        std::cerr << PARMS_FILE << ": serve lo schema BFV" << std::endl;
+        return false;
+    }
+
+    // Il resto del codice (frammentazione, slot, log dei risultati) legge grado e plain modulus da cfg
+    uint64_t plain_modulus = parms.plain_modulus().value();
+    if (parms.poly_modulus_degree() != cfg.poly_modulus_degree || plain_modulus != cfg.plain_modulus) {
+        std::cerr << "Parametri SEAL da " << PARMS_FILE << " (grado " << parms.poly_modulus_degree()
+                  << ", plain modulus " << plain_modulus << ") al posto di quelli della configurazione" << std::endl;
+        cfg.poly_modulus_degree = parms.poly_modulus_degree();
+        cfg.plain_modulus = plain_modulus;
+    }
+    return build_context(parms);
+}
+
+std::shared_ptr<const SEALContext> seal_context()
+{
+    std::lock_guard<std::mutex> lock(context_mtx);
+    if (!shared_context)
+        build_context(make_encryption_parameters(runtime_config()));
+    return shared_context;
+}
+
+size_t ciphertext_moduli(const SEALContext &context)
+{
+    return context.first_context_data()->parms().coeff_modulus().size();
+}
+
+void set_seal_context(std::shared_ptr<const SEALContext> context)
+{
+    std::lock_guard<std::mutex> lock(context_mtx);
+    shared_context = std::move(context);
+}
+
+// Carica una chiave di valutazione salvata da keygen (seeded e compressa: load la espande)
+template <class Keys>
+static std::shared_ptr<const Keys> load_keys(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << path << " non trovato (generarlo con keygen)" << std::endl;
+        return nullptr;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto keys = std::make_shared<Keys>();
+    try {
+        keys->load(*seal_context(), file);
+    } catch (const std::exception &e) {
+        std::cerr << path << " non valido per i parametri correnti: " << e.what() << std::endl;
+        return nullptr;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Caricato " << path << " (" << file.tellg() << " bytes, " << ms << " ms)" << std::endl;
+    return keys;
+}
+
+std::shared_ptr<const RelinKeys> relin_keys()
+{
+    std::lock_guard<std::mutex> lock(keys_mtx);
+    if (!relin_loaded) {
+        shared_relin_keys = load_keys<RelinKeys>(RELIN_KEYS_FILE);
+        relin_loaded = true;
+    }
+    return shared_relin_keys;
+}
+
+std::shared_ptr<const GaloisKeys> galois_keys()
+{
+    std::lock_guard<std::mutex> lock(keys_mtx);
+    if (!galois_loaded) {
+        shared_galois_keys = load_keys<GaloisKeys>(GALOIS_KEYS_FILE);
+        galois_loaded = true;
+    }
+    return shared_galois_keys;
+}
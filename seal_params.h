@@ -0,0 +1,49 @@
+#ifndef SEAL_PARAMS_H
+#define SEAL_PARAMS_H
+
+#include <memory>
+#include "seal/seal.h"
+
+#include "runtime_config.h"
+
+// Parametri SEAL scritti da keygen accanto alle chiavi: sender, receiver e forwarder li caricano da
+// qui, per cui non possono divergere da quelli con cui sono state generate le chiavi
+constexpr const char *PARMS_FILE = "seal.parms";
+
+// Chiavi di valutazione opzionali (keygen --relin, --galois): servono al forwarder solo per
+// moltiplicazioni e rotazioni degli slot
+constexpr const char *RELIN_KEYS_FILE = "relin.key";
+constexpr const char *GALOIS_KEYS_FILE = "galois.key";
+
+// Parametri BFV dalla configurazione (grado, plain modulus, coeff modulus di default di SEAL)
+seal::EncryptionParameters make_encryption_parameters(const RuntimeConfig &cfg);
+
+bool save_encryption_parameters(const seal::EncryptionParameters &parms, const char *path = PARMS_FILE);
+
+// Costruisce il contesto SEAL del processo, da chiamare all'avvio dopo il parsing della configurazione
+// e prima di creare i thread. Se PARMS_FILE esiste i parametri vengono da lì e grado e plain modulus
+// di cfg vengono allineati (con un avviso se erano diversi), altrimenti dalla configurazione.
+// Ritorna false se il file non è leggibile o i parametri non sono validi
+bool init_seal_context(RuntimeConfig &cfg);
+
+// Contesto condiviso in sola lettura da tutti i thread (SEALContext, con le tabelle NTT e i primi
+// RNS, viene costruito una volta sola invece che in ogni HEContext). Senza init_seal_context viene
+// costruito alla prima chiamata dalla configurazione corrente
+std::shared_ptr<const seal::SEALContext> seal_context();
+
+// Moduli RNS di un ciphertext fresco (livello dati): con il grado individua l'insieme di parametri
+// specializzato (param_set.h)
+size_t ciphertext_moduli(const seal::SEALContext &context);
+
+// Sostituisce il contesto condiviso (per i benchmark con più gradi nello stesso processo): vale
+// per gli HEContext creati dopo
+void set_seal_context(std::shared_ptr<const seal::SEALContext> context);
+
+// Chiavi di valutazione condivise in sola lettura da tutti i thread. Il file viene caricato alla
+// prima chiamata (le Galois key possono essere decine di MB: chi non le usa non le carica) e una
+// sola volta per processo; nullptr se il file non esiste o non corrisponde al contesto.
+// Da chiamare in inizializzazione e non per ogni messaggio (la chiamata prende un lock)
+std::shared_ptr<const seal::RelinKeys> relin_keys();
+std::shared_ptr<const seal::GaloisKeys> galois_keys();
+
+#endif
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstring>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -14,7 +15,9 @@
 #include <thread>
 #include "seal/seal.h"
 #include "message.h"
-#include "config.h"
+#include "batcher.h"
+#include "runtime_config.h"
+#include "seal_params.h"
 
 using namespace seal;
 
@@ -25,8 +28,76 @@ un hash che viene calcolato anche considerando la porta di destinazione. Mandand
 su porte diverse, è come se ad ogni thread venisse associata una diversa porta.
 */
 
-void send_worker(int thread_id, std::string dest_ip, int total_rate, int n_msg, const std::vector<seal::seal_byte>& ciphertext_buffer) {
-    uint16_t port = BASE_PORT + thread_id;
+// Oggetti SEAL condivisi tra i thread (i metodi usati sono const)
+struct CryptoState {
+    const BatchEncoder* encoder;
+    const Encryptor* encryptor;
+    bool symmetric;
+};
+
+// Configurazione della modalità batching
+struct BatchConfig {
+    bool enabled = false;
+    uint16_t n_sources = 1;
+    std::chrono::microseconds flush_timeout{runtime_config().batch_flush_timeout_us};
+    uint32_t sample_rate = 0;   // Campioni sintetici al secondo per thread (0 = batch riempito subito)
+};
+
+// Codifica e cifra gli slot, e scrive nel payload slot-map + ciphertext serializzato
+static void encrypt_payload(const CryptoState& crypto, const std::vector<uint64_t>& slots,
+                            const std::vector<char>& slot_map, Plaintext& ptx, std::vector<char>& payload) {
+    crypto.encoder->encode(slots, ptx);
+
+    size_t map_size = slot_map.size();
+    if (crypto.symmetric) {
+        // Modalità simmetrica: il sender possiede la secret key. encrypt_symmetric restituisce un
+        // Serializable<Ciphertext> "seeded", in cui il secondo polinomio viene sostituito dal seed
+        // del PRNG: il ciphertext serializzato pesa circa la metà (e servono circa la metà dei frammenti).
+        // Il seed viene espanso automaticamente da Ciphertext::load nel forwarder.
+        Serializable<Ciphertext> sctx = crypto.encryptor->encrypt_symmetric(ptx);
+        payload.resize(map_size + sctx.save_size(seal::compr_mode_type::none));
+        auto written = sctx.save(reinterpret_cast<seal::seal_byte*>(payload.data() + map_size),
+                                 payload.size() - map_size, seal::compr_mode_type::none);
+        payload.resize(map_size + written);
+    } else {
+        Ciphertext ctx;
+        crypto.encryptor->encrypt(ptx, ctx);
+        // seal_byte consente di non usare gli sstream (che obbligherebbero a fare una copia)
+        payload.resize(map_size + ctx.save_size(seal::compr_mode_type::none));
+        ctx.save(reinterpret_cast<seal::seal_byte*>(payload.data() + map_size),
+                 payload.size() - map_size, seal::compr_mode_type::none);
+    }
+    memcpy(payload.data(), slot_map.data(), map_size);
+}
+
+// Prepara i frammenti (header + chunk) del payload. Il message_id viene scritto al momento dell'invio
+static void build_packets(const std::vector<char>& payload, std::vector<std::vector<char>>& packet_buffers) {
+    uint32_t total_size = payload.size();
+    uint32_t num_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // resize non dealloca: con payload di dimensione costante i buffer vengono riusati
+    packet_buffers.resize(num_chunks);
+    
+    for (uint32_t i = 0; i < num_chunks; i++) {
+        uint32_t offset = i * CHUNK_SIZE;
+        uint32_t remaining = total_size - offset;
+        uint32_t chunk_size = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
+        
+        // Header (esteso oltre 65535 chunk)
+        size_t hdr_size = fragment_header_size(num_chunks);
+        packet_buffers[i].resize(hdr_size + chunk_size);
+        write_fragment_header(packet_buffers[i].data(), 0, num_chunks, i, total_size, (uint16_t)chunk_size);
+        
+        // Copia il payload (slot-map + ciphertext)
+        memcpy(packet_buffers[i].data() + hdr_size, 
+               payload.data() + offset, chunk_size);
+    }
+}
+
+void send_worker(int thread_id, std::string dest_ip, int total_rate, int n_msg,
+                 const std::vector<char>& fixed_payload, const CryptoState& crypto, const BatchConfig& batch) {
+    const RuntimeConfig& cfg = runtime_config();
+    uint16_t port = cfg.base_port + thread_id;
 
     // Crea un socket UDP
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -41,45 +112,50 @@ void send_worker(int thread_id, std::string dest_ip, int total_rate, int n_msg,
     dest_addr.sin_port = htons(port);
     inet_pton(AF_INET, dest_ip.c_str(), &dest_addr.sin_addr);
 
-    // Prealloco chunk da inviare
-    uint32_t total_size = ciphertext_buffer.size();
-    uint32_t num_chunks = (total_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
-    
     // Vettore di buffer pre allocati
-    std::vector<std::vector<char>> packet_buffers(num_chunks);
-    
-    for (uint32_t i = 0; i < num_chunks; i++) {
-        uint32_t offset = i * CHUNK_SIZE;
-        uint32_t remaining = total_size - offset;
-        uint32_t chunk_size = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
-        
-        // Preparo header
-        TelemetryHeader hdr;
-        hdr.message_id = 0; 
-        hdr.total_chunks = (uint16_t)num_chunks;
-        hdr.chunk_index = (uint16_t)i;
-        hdr.ciphertext_total_size = total_size;
-        hdr.chunk_size = (uint16_t)chunk_size;
-        
-        packet_buffers[i].resize(sizeof(TelemetryHeader) + chunk_size);
-        
-        // Copia header
-        memcpy(packet_buffers[i].data(), &hdr, sizeof(TelemetryHeader));
-        
-        // Copia il buffer del ciphertext
-        memcpy(packet_buffers[i].data() + sizeof(TelemetryHeader), 
-               ciphertext_buffer.data() + offset, chunk_size);
+    std::vector<std::vector<char>> packet_buffers;
+    if (!batch.enabled) {
+        // Senza batching il payload è sempre lo stesso: i chunk vengono preparati una volta sola
+        build_packets(fixed_payload, packet_buffers);
     }
 
+    // Stato del batching (usato solo se attivo)
+    TelemetryBatcher batcher(crypto.encoder->slot_count(), batch.flush_timeout);
+    std::vector<char> slot_map;
+    std::vector<uint64_t> slots;
+    std::vector<char> payload;
+    Plaintext ptx;
+    uint16_t next_source = 0;
+    const std::chrono::nanoseconds sample_interval(batch.sample_rate > 0 ? 1000000000L / batch.sample_rate : 0);
+    auto next_sample_time = std::chrono::steady_clock::now();
+
     // Calcolo intervallo per thread
-    long interval_ns = (1000000000L * N_PORTS) / total_rate;
+    long interval_ns = (1000000000L * cfg.n_ports) / total_rate;
     
     auto next_send_time = std::chrono::high_resolution_clock::now();
 
-    for (int i = 1 + thread_id; i <= n_msg; i += N_PORTS) {
+    for (int i = 1 + thread_id; i <= n_msg; i += cfg.n_ports) {
+
+        if (batch.enabled) {
+            // Campioni sintetici: le sorgenti producono a turno un campione (il valore è il source_id,
+            // così il receiver può verificare la demultiplazione) finché il batch non è pieno o scade il timeout.
+            // Con sample_rate i campioni arrivano uno per intervallo e un batch non pieno parte per timeout
+            while (!batcher.ready()) {
+                if (batch.sample_rate > 0) {
+                    if (std::chrono::steady_clock::now() < next_sample_time)
+                        continue;
+                    next_sample_time += sample_interval;
+                }
+                batcher.add(next_source, next_source);
+                next_source = (next_source + 1) % batch.n_sources;
+            }
+            batcher.flush(slot_map, slots);
+            encrypt_payload(crypto, slots, slot_map, ptx, payload);
+            build_packets(payload, packet_buffers);
+        }
         
         // Invia i chunk pre allocati
-        for (uint32_t c = 0; c < num_chunks; c++) {
+        for (uint32_t c = 0; c < packet_buffers.size(); c++) {
             // Aggiorna solo il message_id nel buffer già pronto
             TelemetryHeader* hdr_ptr = (TelemetryHeader*)packet_buffers[c].data();
             hdr_ptr->message_id = i;
@@ -103,59 +179,117 @@ void send_worker(int thread_id, std::string dest_ip, int total_rate, int n_msg,
 }
 
 int main(int argc, char* argv[]) {
+    // Parametri da config.h, modificabili con --config <file> o --<parametro> <valore>
+    // (tolti da argv prima del parsing delle opzioni del sender)
+    RuntimeConfig& cfg = runtime_config();
+    if (!parse_config_args(cfg, argc, argv))
+        return 1;
+
     if (argc < 4) {
-        std::cerr << "Argomenti non validi: <IP_destinazione> <rate> <n_messaggi>" << std::endl;
+        std::cerr << "Argomenti non validi: <IP_destinazione> <rate> <n_messaggi> [--symmetric] "
+                  << "[--batch <n_sorgenti>] [--flush-us <timeout>] [--sample-rate <campioni/s>] [--config <file>] [--<parametro> <valore>]" << std::endl;
         return 1;
     }
     
     std::string dest_ip = argv[1];
     int rate = atoi(argv[2]);
     int n_msg = atoi(argv[3]);
+
+    // Opzioni facoltative dopo gli argomenti posizionali
+    bool symmetric = false;
+    BatchConfig batch;
+    for (int i = 4; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--symmetric") {
+            symmetric = true;
+        } else if (opt == "--batch" && i + 1 < argc) {
+            batch.enabled = true;
+            batch.n_sources = static_cast<uint16_t>(atoi(argv[++i]));
+        } else if (opt == "--flush-us" && i + 1 < argc) {
+            batch.flush_timeout = std::chrono::microseconds(atoi(argv[++i]));
+        } else if (opt == "--sample-rate" && i + 1 < argc) {
+            int sample_rate = atoi(argv[++i]);
+            if (sample_rate <= 0) {
+                std::cerr << "Il rate dei campioni deve essere > 0" << std::endl;
+                return 1;
+            }
+            batch.sample_rate = sample_rate;
+        } else {
+            std::cerr << "Opzione sconosciuta: " << opt << std::endl;
+            return 1;
+        }
+    }
     
     if (rate <= 0) {
         std::cerr << "Il rate deve essere > 0" << std::endl;
         return 1;
     }
-
-    // Setup SEAL con parametri da config.h
-    EncryptionParameters parms(scheme_type::bfv);
-    parms.set_poly_modulus_degree(POLY_MODULUS_DEGREE);
-    parms.set_coeff_modulus(CoeffModulus::BFVDefault(POLY_MODULUS_DEGREE));
-    parms.set_plain_modulus(PLAIN_MODULUS);
-    SEALContext context(parms);
-
-    // Carica public key da file
-    PublicKey public_key;
-    std::ifstream pk_file("public.key", std::ios::binary);
-    if (!pk_file) {
-        std::cerr << "public.key non trovata" << std::endl;
+    if (batch.enabled && batch.n_sources == 0) {
+        std::cerr << "Il numero di sorgenti deve essere > 0" << std::endl;
         return 1;
     }
-    public_key.load(context, pk_file);
-    pk_file.close();
-    std::cout << "Chiave pubblica caricata" << std::endl;
 
-    Encryptor encryptor(context, public_key);
+    // Setup SEAL (parametri da seal.parms scritto da keygen)
+    if (!init_seal_context(cfg))
+        return 1;
+    const SEALContext &context = *seal_context();
+
     BatchEncoder encoder(context);
+    std::unique_ptr<Encryptor> encryptor;
 
-    // Crea un ciphertext con tutti gli elementi uguali a 0
-    std::vector<uint64_t> valori(encoder.slot_count(), 0ULL);
-    Plaintext ptx;
-    encoder.encode(valori, ptx);
-    Ciphertext ctx;
-    encryptor.encrypt(ptx, ctx);
+    if (symmetric) {
+        // In modalità simmetrica serve la secret key al posto della public key
+        SecretKey secret_key;
+        std::ifstream sk_file("secret.key", std::ios::binary);
+        if (!sk_file) {
+            std::cerr << "secret.key non trovata" << std::endl;
+            return 1;
+        }
+        secret_key.load(context, sk_file);
+        sk_file.close();
+        std::cout << "Secret key caricata (modalità simmetrica)" << std::endl;
+        encryptor.reset(new Encryptor(context, secret_key));
+    } else {
+        // Carica public key da file
+        PublicKey public_key;
+        std::ifstream pk_file("public.key", std::ios::binary);
+        if (!pk_file) {
+            std::cerr << "public.key non trovata" << std::endl;
+            return 1;
+        }
+        public_key.load(context, pk_file);
+        pk_file.close();
+        std::cout << "Chiave pubblica caricata" << std::endl;
+        encryptor.reset(new Encryptor(context, public_key));
+    }
 
-    // seal_byte consente di non usare gli sstream (che obbligerebbero a fare una copia)
-    std::vector<seal::seal_byte> ciphertext_buffer(ctx.save_size(seal::compr_mode_type::none));
-    ctx.save(ciphertext_buffer.data(), ciphertext_buffer.size(), seal::compr_mode_type::none);
-    std::cout << "Ciphertext: " << ciphertext_buffer.size() << " bytes" << std::endl;
+    CryptoState crypto{&encoder, encryptor.get(), symmetric};
+
+    // Senza batching: un ciphertext con tutti gli elementi uguali a 0 e slot-map vuota,
+    // cifrato una volta sola e reinviato con message_id diversi
+    std::vector<char> fixed_payload;
+    if (!batch.enabled) {
+        std::vector<uint64_t> valori(encoder.slot_count(), 0ULL);
+        std::vector<char> empty_map(sizeof(SlotMapHeader), 0);
+        Plaintext ptx;
+        encrypt_payload(crypto, valori, empty_map, ptx, fixed_payload);
+        std::cout << "Payload: " << fixed_payload.size() << " bytes ("
+                  << (fixed_payload.size() + CHUNK_SIZE - 1) / CHUNK_SIZE << " frammenti)" << std::endl;
+    } else {
+        std::cout << "Batching attivo: " << batch.n_sources << " sorgenti, " << encoder.slot_count()
+                  << " slot per ciphertext, flush dopo " << batch.flush_timeout.count() << " us";
+        if (batch.sample_rate > 0)
+            std::cout << ", " << batch.sample_rate << " campioni/s per thread";
+        std::cout << std::endl;
+    }
 
-    std::cout << "Invio a " << dest_ip << " su porte " << BASE_PORT << "-" << (BASE_PORT + N_PORTS - 1) 
-              << " con " << N_PORTS << " thread." << std::endl;
+    std::cout << "Invio a " << dest_ip << " su porte " << cfg.base_port << "-" << (cfg.base_port + cfg.n_ports - 1) 
+              << " con " << cfg.n_ports << " thread." << std::endl;
 
     std::vector<std::thread> threads;
-    for (int i = 0; i < N_PORTS; i++) {
-        threads.emplace_back(send_worker, i, dest_ip, rate, n_msg, std::cref(ciphertext_buffer));
+    for (int i = 0; i < cfg.n_ports; i++) {
+        threads.emplace_back(send_worker, i, dest_ip, rate, n_msg,
+                             std::cref(fixed_payload), std::cref(crypto), std::cref(batch));
     }
 
     for (auto& t : threads) {
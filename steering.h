@@ -0,0 +1,60 @@
+#ifndef STEERING_H
+#define STEERING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "aggregator.h"
+#include "packet_io.h"
+#include "ring.h"
+
+// Frammento di telemetria consegnato al lcore proprietario del suo messaggio
+struct SteeredFragment {
+    FlowRoute route;                 // Indirizzi del pacchetto originale (usati per la risposta)
+    uint16_t out_port;               // Porta di uscita della risposta (la coda è quella del proprietario)
+    uint16_t len;                    // Byte validi in data
+    char data[PACKET_IO_BUF_SIZE];   // Payload UDP: TelemetryHeader + chunk
+};
+
+// Steering per message_id. L'RSS calcola l'hash su indirizzi e porte, non sul message_id, quindi
+// i frammenti di uno stesso messaggio arrivano sulla stessa coda solo se il sender li manda tutti
+// dalla stessa porta. Con lo steering ogni messaggio ha un lcore proprietario (message_id % n_workers):
+// un lcore che riceve un frammento non suo lo copia nella coda del proprietario, che lo riassembla.
+// Il carico viene bilanciato per messaggio con qualsiasi disposizione di porte del sender
+class MessageSteering {
+public:
+    MessageSteering(uint16_t n_workers, size_t ring_size)
+        : n_workers(n_workers)
+    {
+        for (uint16_t i = 0; i < n_workers; i++)
+            rings.emplace_back(new BoundedRing<SteeredFragment>(ring_size));
+    }
+
+    uint16_t owner(uint32_t message_id) const { return message_id % n_workers; }
+
+    // Ritorna false (e conta il frammento come perso) se la coda del proprietario è piena
+    bool push(uint16_t worker, const SteeredFragment &frag)
+    {
+        if (rings[worker]->try_push(frag))
+            return true;
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool pop(uint16_t worker, SteeredFragment &frag) { return rings[worker]->try_pop(frag); }
+
+    // Frammenti in attesa nella coda di worker (approssimato)
+    size_t backlog(uint16_t worker) const { return rings[worker]->size(); }
+
+    uint16_t get_n_workers() const { return n_workers; }
+    uint64_t get_dropped() const { return dropped.load(); }
+
+private:
+    uint16_t n_workers;
+    std::vector<std::unique_ptr<BoundedRing<SteeredFragment>>> rings;  // Una coda in ingresso per lcore
+    std::atomic<uint64_t> dropped{0};
+};
+
+#endif
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "stream_patcher.h"
+
+using namespace seal;
+
+// Inizio del ciphertext serializzato da verificare prima di correggere: SEALHeader (magic, versione e
+// compressione nei primi 8 byte, dimensione totale negli 8 successivi, diversa per i ciphertext seeded),
+// poi parms_id, forma NTT, numero di polinomi, grado e numero di moduli
+constexpr size_t CT_HEADER_CHECK = 16 + sizeof(parms_id_type) + 1 + 3 * sizeof(uint64_t);
+constexpr size_t CT_SIZE_FIELD = 8;     // Byte 8..15: dimensione totale, non confrontata
+constexpr size_t CT_COMPR_FIELD = 5;    // compr_mode_type del SEALHeader
+constexpr size_t DONE_SLOTS = 1024;
+
+bool StreamPatcher::init(HEContext &he, uint64_t number)
+{
+    const SEALContext &context = *he.context;
+    auto context_data = context.first_context_data();
+    const auto &coeff_modulus = context_data->parms().coeff_modulus();
+    const size_t n = context_data->parms().poly_modulus_degree();
+    const size_t k = coeff_modulus.size();
+
+    // Costante scalata: la somma a un ciphertext nullo lascia in c0 solo il plaintext scalato
+    Ciphertext ct(context, context.first_parms_id(), he.pool);
+    ct.resize(context, context.first_parms_id(), 2);
+    he.add_plain_number(ct, number);
+    moduli.resize(k);
+    scaled.resize(k);
+    for (size_t j = 0; j < k; j++) {
+        moduli[j] = coeff_modulus[j].value();
+        scaled[j] = ct.data(0)[j * n];
+        for (size_t i = 1; i < n; i++) {
+            if (ct.data(0)[j * n + i] != 0)
+                return false;
+        }
+    }
+
+    // Posizione di c0 nel ciphertext serializzato: si salva un ciphertext con valori riconoscibili nel
+    // coefficiente 0 di ogni modulo e li si cerca nel buffer
+    const uint64_t marker = 0x5eed0fc0ffee0000ull;
+    ct.resize(context, context.first_parms_id(), 2);
+    std::fill(ct.data(), ct.data() + 2 * n * k, 0);
+    for (size_t j = 0; j < k; j++)
+        ct.data(0)[j * n] = marker + j;
+    std::vector<seal_byte> probe(ct.save_size(compr_mode_type::none));
+    probe.resize(ct.save(probe.data(), probe.size(), compr_mode_type::none));
+
+    size_t c0_offset = 0;
+    for (size_t pos = CT_HEADER_CHECK; pos + sizeof(uint64_t) <= probe.size() && c0_offset == 0; pos++) {
+        if (memcmp(probe.data() + pos, &marker, sizeof(uint64_t)) == 0)
+            c0_offset = pos;
+    }
+    if (c0_offset == 0 || c0_offset + ((k - 1) * n + 1) * sizeof(uint64_t) > probe.size())
+        return false;
+
+    header.assign((const uint8_t *)probe.data(), (const uint8_t *)probe.data() + CT_HEADER_CHECK);
+    regions.clear();
+    regions.push_back({0, CT_HEADER_CHECK, 0});
+    region_bytes = CT_HEADER_CHECK;
+    for (size_t j = 0; j < k; j++) {
+        uint64_t value = marker + j;
+        size_t offset = c0_offset + j * n * sizeof(uint64_t);
+        if (memcmp(probe.data() + offset, &value, sizeof(uint64_t)) != 0)
+            return false;
+        regions.push_back({offset, sizeof(uint64_t), region_bytes});
+        region_bytes += sizeof(uint64_t);
+    }
+
+    done.assign(DONE_SLOTS, 0);
+    return true;
+}
+
+StreamPatcher::Action StreamPatcher::process(char *fragment, size_t len, bool &complete)
+{
+    complete = false;
+
+    FragmentInfo info;
+    if (!parse_fragment_header(fragment, len, info))
+        return Action::Drop;
+    if ((uint64_t)info.chunk_index * CHUNK_SIZE + info.chunk_size > info.total_size)
+        return Action::Drop;
+    // Duplicato di un messaggio già completato
+    if (done[info.message_id % DONE_SLOTS] == (uint64_t)info.message_id + 1)
+        return Action::Drop;
+
+    auto it = messages.emplace(info.message_id, MessageState{}).first;
+    MessageState &msg = it->second;
+    if (msg.total_chunks == 0) {
+        msg.total_chunks = info.total_chunks;
+        msg.total_size = info.total_size;
+        msg.opened = std::chrono::steady_clock::now();
+        msg.chunk_received.assign((info.total_chunks + 63) / 64, 0);
+        msg.bytes.assign(region_bytes, 0);
+        msg.filled.assign(regions.size(), 0);
+    }
+    if (info.total_chunks != msg.total_chunks || info.total_size != msg.total_size)
+        return Action::Drop;
+
+    uint64_t &word = msg.chunk_received[info.chunk_index / 64];
+    uint64_t bit = 1ull << (info.chunk_index % 64);
+    if (word & bit)
+        return Action::Drop;
+    word |= bit;
+    msg.received++;
+
+    Action action = Action::Drop;
+    if (!msg.bad) {
+        if (msg.map_size == 0 && info.chunk_index == 0)
+            read_slot_map(msg, fragment + info.header_size, info.chunk_size);
+        if (!msg.bad && msg.map_size > 0)
+            collect(msg, fragment);
+
+        if (!msg.bad && try_patch(msg, fragment)) {
+            action = Action::Forward;
+        } else if (!msg.bad) {
+            msg.held.emplace_back(fragment, fragment + len);
+            action = Action::Held;
+        }
+        if (!msg.bad)
+            release_held(msg);
+    }
+    if (msg.bad) {
+        msg.held.clear();
+        action = Action::Drop;
+    }
+
+    if (msg.received == msg.total_chunks) {
+        complete = !msg.bad;
+        done[info.message_id % DONE_SLOTS] = (uint64_t)info.message_id + 1;
+        messages.erase(it);
+    }
+    return action;
+}
+
+size_t StreamPatcher::expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds timeout)
+{
+    if (now - last_expire < std::chrono::milliseconds(1))
+        return 0;
+    last_expire = now;
+
+    size_t expired = 0;
+    for (auto it = messages.begin(); it != messages.end();) {
+        if (now - it->second.opened >= timeout) {
+            done[it->first % DONE_SLOTS] = (uint64_t)it->first + 1;
+            it = messages.erase(it);
+            expired++;
+        } else {
+            ++it;
+        }
+    }
+    return expired;
+}
+
+void StreamPatcher::read_slot_map(MessageState &msg, const char *chunk, size_t size)
+{
+    if (size < sizeof(SlotMapHeader)) {
+        msg.bad = true;
+        return;
+    }
+    SlotMapHeader map_hdr;
+    memcpy(&map_hdr, chunk, sizeof(SlotMapHeader));
+    size_t map_size = sizeof(SlotMapHeader) + map_hdr.n_entries * sizeof(SlotMapEntry);
+    const Region &last = regions.back();
+    if (map_size + last.offset + last.len > msg.total_size) {
+        msg.bad = true;
+        return;
+    }
+
+    // Da qui si conoscono le posizioni delle regioni: si raccolgono i frammenti arrivati prima
+    msg.map_size = map_size;
+    for (auto &held : msg.held)
+        collect(msg, held.data());
+}
+
+void StreamPatcher::collect(MessageState &msg, const char *fragment)
+{
+    FragmentInfo info;
+    parse_fragment_header(fragment, SIZE_MAX, info);
+    size_t begin = (size_t)info.chunk_index * CHUNK_SIZE;
+    size_t end = begin + info.chunk_size;
+    const char *chunk = fragment + info.header_size;
+
+    for (size_t r = 0; r < regions.size(); r++) {
+        size_t start = msg.map_size + regions[r].offset;
+        size_t lo = std::max(start, begin);
+        size_t hi = std::min(start + regions[r].len, end);
+        if (lo >= hi)
+            continue;
+        memcpy(msg.bytes.data() + regions[r].buf + (lo - start), chunk + (lo - begin), hi - lo);
+        msg.filled[r] += hi - lo;
+
+        // Header completo: i parametri devono essere quelli del contesto e il ciphertext non compresso
+        if (r == 0 && msg.filled[0] == regions[0].len) {
+            const uint8_t *got = msg.bytes.data();
+            if (memcmp(got, header.data(), CT_SIZE_FIELD) != 0 ||
+                got[CT_COMPR_FIELD] != (uint8_t)compr_mode_type::none ||
+                memcmp(got + 2 * CT_SIZE_FIELD, header.data() + 2 * CT_SIZE_FIELD, CT_HEADER_CHECK - 2 * CT_SIZE_FIELD) != 0) {
+                std::cerr << "Cut-through: ciphertext del messaggio " << info.message_id
+                          << " compresso o con parametri diversi, scartato" << std::endl;
+                msg.bad = true;
+            }
+        }
+    }
+}
+
+bool StreamPatcher::try_patch(MessageState &msg, char *fragment)
+{
+    // Prima si controlla che tutte le regioni del frammento siano complete (e verificato l'header),
+    // poi si scrive: un frammento che torna in attesa resta con i byte originali
+    if (msg.map_size == 0 || msg.filled[0] < regions[0].len)
+        return false;
+
+    FragmentInfo info;
+    parse_fragment_header(fragment, SIZE_MAX, info);
+    size_t begin = (size_t)info.chunk_index * CHUNK_SIZE;
+    size_t end = begin + info.chunk_size;
+    char *chunk = fragment + info.header_size;
+
+    for (size_t r = 1; r < regions.size(); r++) {
+        size_t start = msg.map_size + regions[r].offset;
+        if (start < end && start + regions[r].len > begin && msg.filled[r] < regions[r].len)
+            return false;
+    }
+
+    for (size_t r = 1; r < regions.size(); r++) {
+        size_t start = msg.map_size + regions[r].offset;
+        size_t lo = std::max(start, begin);
+        size_t hi = std::min(start + regions[r].len, end);
+        if (lo >= hi)
+            continue;
+
+        uint64_t value;
+        memcpy(&value, msg.bytes.data() + regions[r].buf, sizeof(uint64_t));
+        uint64_t q = moduli[r - 1];
+        uint64_t s = value + scaled[r - 1];
+        value = s - (s >= q ? q : 0);
+        memcpy(chunk + (lo - begin), (const uint8_t *)&value + (lo - start), hi - lo);
+    }
+    return true;
+}
+
+void StreamPatcher::release_held(MessageState &msg)
+{
+    for (size_t i = 0; i < msg.held.size();) {
+        if (try_patch(msg, msg.held[i].data())) {
+            ready.push_back(std::move(msg.held[i]));
+            msg.held[i] = std::move(msg.held.back());
+            msg.held.pop_back();
+        } else {
+            i++;
+        }
+    }
+}
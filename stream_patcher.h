@@ -0,0 +1,89 @@
+#ifndef STREAM_PATCHER_H
+#define STREAM_PATCHER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "he_context.h"
+#include "message.h"
+
+// Cut-through dei messaggi nel forwarder: invece di riassemblare il ciphertext, ogni frammento viene
+// inoltrato appena arriva. La somma con una costante codificata con BatchEncoder cambia solo il
+// coefficiente 0 di ogni componente RNS di c0 (vedi HEContext::add_plain_number_fast), cioè 8 byte per
+// modulo in posizioni note appena si conosce la dimensione della slot-map: si correggono quei byte nei
+// frammenti che li contengono e tutto il resto passa invariato.
+// Vengono trattenuti (copiati) solo i frammenti che non si possono ancora correggere: quelli arrivati
+// prima del frammento 0 (che contiene la slot-map) o prima dell'header del ciphertext, e quelli con un
+// coefficiente a cavallo di un frammento non ancora arrivato. Con le perdite un messaggio resta
+// incompleto: expire lo scarta (con le sue copie) dopo stream-timeout-ms.
+// Vale per ciphertext serializzati senza compressione come li invia il sender, anche seeded (c0 è nella
+// stessa posizione; il receiver espande il seed). Una istanza per lcore
+class StreamPatcher {
+public:
+    enum class Action : uint8_t {
+        Forward,  // Frammento corretto sul posto, da inoltrare subito
+        Held,     // Copiato: uscirà da released() quando sarà correggibile
+        Drop      // Duplicato, incoerente o di un messaggio non valido
+    };
+
+    // Posizioni dei coefficienti e costante scalata per i parametri di he.context.
+    // Ritorna false se la costante codificata non è un polinomio di grado 0
+    bool init(HEContext &he, uint64_t number);
+
+    // fragment: header di telemetria + chunk, corretto sul posto se il risultato è Forward.
+    // complete diventa true quando arriva l'ultimo frammento di un messaggio valido
+    Action process(char *fragment, size_t len, bool &complete);
+
+    // Frammenti trattenuti diventati inoltrabili (header + chunk, già corretti): li svuota il chiamante
+    std::vector<std::vector<char>> &released() { return ready; }
+
+    // Messaggi con almeno un frammento ricevuto e non ancora completati
+    size_t in_flight() const { return messages.size(); }
+
+    // Scarta i messaggi incompleti aperti da almeno timeout (con i frammenti trattenuti): i loro frammenti
+    // in ritardo verranno scartati come duplicati. Controlla al massimo una volta per millisecondo.
+    // Ritorna i messaggi scartati
+    size_t expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds timeout);
+
+private:
+    struct MessageState {
+        uint32_t total_chunks = 0;
+        uint32_t total_size = 0;
+        uint32_t received = 0;
+        size_t map_size = 0;                       // 0 finché non arriva il frammento 0
+        bool bad = false;                          // Ciphertext non correggibile: i frammenti vengono scartati
+        std::chrono::steady_clock::time_point opened;  // Arrivo del primo frammento
+        std::vector<uint64_t> chunk_received;
+        std::vector<uint8_t> bytes;                // Byte delle regioni (header e coefficienti) raccolti dai frammenti
+        std::vector<uint32_t> filled;              // Byte raccolti per regione
+        std::vector<std::vector<char>> held;
+    };
+
+    // Regione del ciphertext da raccogliere: 0 è l'header (verificato prima di correggere qualsiasi
+    // frammento), le altre il coefficiente 0 di c0 per ogni modulo
+    struct Region {
+        size_t offset;   // Dall'inizio del ciphertext serializzato
+        size_t len;
+        size_t buf;      // Posizione in MessageState::bytes
+    };
+
+    void read_slot_map(MessageState &msg, const char *chunk, size_t size);
+    void collect(MessageState &msg, const char *fragment);
+    bool try_patch(MessageState &msg, char *fragment);
+    void release_held(MessageState &msg);
+
+    std::vector<Region> regions;
+    size_t region_bytes = 0;
+    std::vector<uint8_t> header;                   // Header atteso (byte con parms_id, forma NTT, size, grado, moduli)
+    std::vector<uint64_t> moduli;
+    std::vector<uint64_t> scaled;                  // Costante scalata per modulo
+    std::unordered_map<uint32_t, MessageState> messages;
+    std::vector<uint64_t> done;                    // message_id + 1 completati, per message_id % slot (duplicati tardivi)
+    std::vector<std::vector<char>> ready;
+    std::chrono::steady_clock::time_point last_expire;
+};
+
+#endif
@@ -0,0 +1,299 @@
+// Forwarder portabile: stesso datapath di rss_forwarding (forwarder.cpp) ma senza DOCA Flow,
+// per test di carico e regressioni prestazionali su qualsiasi macchina Linux.
+//
+// Uso:
+//   sw_forwarding afpacket <interfaccia_ingress> <interfaccia_egress> [n_thread]
+//   sw_forwarding xdp <interfaccia_ingress> <interfaccia_egress> [n_code] [programma_xdp.o]
+//     (solo se compilato con libxdp; le code devono esistere sulle interfacce, es. ethtool -L)
+//   sw_forwarding dpdk <argomenti EAL>   (solo se compilato con DPDK), es. con device virtuali:
+//     sw_forwarding dpdk -l 0-3 --vdev=net_pcap0,rx_pcap=in.pcap,tx_pcap=out.pcap --vdev=net_null0
+//   Prima del backend si possono dare --config <file> e --<parametro> <valore> (vedi runtime_config.h),
+//   es. sw_forwarding --burst-size 64 --rx-queue-size 1024 afpacket veth0 veth1 4
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "forwarder.h"
+#include "packet_io_afpacket.h"
+#include "runtime_config.h"
+#include "seal_params.h"
+
+#ifdef FWD_WITH_XDP
+#include "packet_io_xdp.h"
+#endif
+
+#ifdef FWD_WITH_DPDK
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include "packet_io_dpdk.h"
+#endif
+
+// Il ciclo di polling termina quando viene richiesta l'uscita
+static std::atomic_bool exit_request(false);
+
+static void handle_exit_signal(int sig)
+{
+    (void)sig;
+    exit_request.store(true);
+}
+
+static MessageSteering *create_steering(uint16_t n_workers)
+{
+    const RuntimeConfig &cfg = runtime_config();
+    if (!cfg.steer_by_message_id)
+        return nullptr;
+
+    std::cout << "Steering per message_id su " << n_workers << " thread" << std::endl;
+    return new MessageSteering(n_workers, cfg.steer_ring_size);
+}
+
+static AggregationTable *create_agg_table()
+{
+    const RuntimeConfig &cfg = runtime_config();
+    if (cfg.agg_window_msgs == 0)
+        return nullptr;
+
+    std::cout << "Aggregazione attiva: " << cfg.agg_window_msgs << " messaggi o "
+              << cfg.agg_window_ms << " ms per finestra" << std::endl;
+    return new AggregationTable(cfg.agg_window_msgs, std::chrono::milliseconds(cfg.agg_window_ms));
+}
+
+// Statistiche dei primi n_workers lcore e, se richiesta, la riga periodica
+static std::thread start_stats(unsigned n_workers)
+{
+    set_stats_lcore_count(n_workers);
+    if (runtime_config().stats_interval_ms == 0)
+        return std::thread();
+    return start_stats_reporter(runtime_config().stats_interval_ms, exit_request);
+}
+
+// Un thread per coda, con la stessa coda su ingress ed egress: il Forwarder viene creato dentro
+// al thread che lo usa
+static void run_worker_threads(PacketIO &io, AggregationTable *agg_table, int n_threads)
+{
+    MessageSteering *steering = create_steering(n_threads);
+    std::thread stats_thread = start_stats(n_threads);
+
+    std::vector<std::thread> threads;
+    for (int q = 0; q < n_threads; q++) {
+        threads.emplace_back([&io, agg_table, steering, q]() {
+            ForwardingQueues queues;
+            queues.ingress.port_id = 0;
+            queues.ingress.queue_id = q;
+            queues.egress.port_id = 1;
+            queues.egress.queue_id = q;
+
+            Forwarder fwd(io, agg_table, steering, q);
+            run_forwarding_loop(fwd, queues, runtime_config().burst_size, exit_request);
+        });
+    }
+
+    for (auto &t : threads)
+        t.join();
+    if (stats_thread.joinable())
+        stats_thread.join();
+
+    delete steering;
+}
+
+static int run_afpacket(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::cerr << "Argomenti non validi: afpacket <interfaccia_ingress> <interfaccia_egress> [n_thread]" << std::endl;
+        return 1;
+    }
+    int n_threads = (argc > 4) ? atoi(argv[4]) : 1;
+    if (n_threads <= 0 || (unsigned)n_threads > STATS_MAX_LCORES) {
+        std::cerr << "Il numero di thread deve essere compreso tra 1 e " << STATS_MAX_LCORES << std::endl;
+        return 1;
+    }
+
+    AfPacketIO io;
+    if (!io.open({argv[2], argv[3]}, n_threads))
+        return 1;
+
+    AggregationTable *agg_table = create_agg_table();
+
+    std::cout << "Backend AF_PACKET: " << argv[2] << " <-> " << argv[3]
+              << " con " << n_threads << " thread" << std::endl;
+
+    run_worker_threads(io, agg_table, n_threads);
+
+    delete agg_table;
+    return 0;
+}
+
+#ifdef FWD_WITH_XDP
+static int run_xdp(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::cerr << "Argomenti non validi: xdp <interfaccia_ingress> <interfaccia_egress> [n_code] [programma_xdp.o]" << std::endl;
+        return 1;
+    }
+    int n_queues = (argc > 4) ? atoi(argv[4]) : 1;
+    if (n_queues <= 0 || (unsigned)n_queues > STATS_MAX_LCORES) {
+        std::cerr << "Il numero di code deve essere compreso tra 1 e " << STATS_MAX_LCORES << std::endl;
+        return 1;
+    }
+    std::string bpf_obj = (argc > 5) ? argv[5] : XDP_BPF_OBJ_PATH;
+
+    XdpPacketIO io;
+    if (!io.open({argv[2], argv[3]}, n_queues, bpf_obj))
+        return 1;
+
+    AggregationTable *agg_table = create_agg_table();
+
+    std::cout << "Backend AF_XDP: " << argv[2] << " <-> " << argv[3]
+              << " con " << n_queues << " code" << std::endl;
+
+    run_worker_threads(io, agg_table, n_queues);
+
+    delete agg_table;
+    return 0;
+}
+#endif
+
+#ifdef FWD_WITH_DPDK
+struct DpdkWorkerArgs {
+    struct rte_mempool *pool;
+    AggregationTable *agg_table;
+    MessageSteering *steering;
+    uint16_t nb_queues;
+};
+
+static int dpdk_worker(void *arg)
+{
+    const DpdkWorkerArgs *wargs = (const DpdkWorkerArgs *)arg;
+    const int worker_id = rte_lcore_index(rte_lcore_id());
+    if (worker_id < 0 || worker_id >= wargs->nb_queues)
+        return 0;
+
+    ForwardingQueues queues;
+    queues.ingress.port_id = 0;
+    queues.ingress.queue_id = worker_id;
+    queues.egress.port_id = 1;
+    queues.egress.queue_id = worker_id;
+
+    DpdkPacketIO io(wargs->pool);
+    Forwarder fwd(io, wargs->agg_table, wargs->steering, worker_id);
+    run_forwarding_loop(fwd, queues, runtime_config().burst_size, exit_request);
+    return 0;
+}
+
+static int run_dpdk(int argc, char *argv[])
+{
+    // Gli argomenti dopo "dpdk" vengono passati all'EAL (argv[1] fa da nome del programma)
+    int ret = rte_eal_init(argc - 1, argv + 1);
+    if (ret < 0) {
+        std::cerr << "rte_eal_init fallita" << std::endl;
+        return 1;
+    }
+
+    if (rte_eth_dev_count_avail() != 2) {
+        std::cerr << "Servono esattamente 2 porte DPDK (es. --vdev=net_ring0 --vdev=net_ring1)" << std::endl;
+        rte_eal_cleanup();
+        return 1;
+    }
+
+    // Una coda per lcore, nei limiti supportati dai device (i vdev spesso ne hanno una sola)
+    uint16_t nb_queues = rte_lcore_count();
+    for (uint16_t port = 0; port < 2; port++) {
+        struct rte_eth_dev_info dev_info;
+        if (rte_eth_dev_info_get(port, &dev_info) == 0)
+            nb_queues = std::min({nb_queues, dev_info.max_rx_queues, dev_info.max_tx_queues});
+    }
+    if (nb_queues > STATS_MAX_LCORES) {
+        std::cerr << "Troppi lcore: al massimo " << STATS_MAX_LCORES << " code per porta" << std::endl;
+        rte_eal_cleanup();
+        return 1;
+    }
+
+    struct rte_mempool *pool = rte_pktmbuf_pool_create(
+        "MBUF_POOL", (1 << 14) - 1, /* per thread cache size */ 256, 0,
+        RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+    if (!pool) {
+        std::cerr << "rte_pktmbuf_pool_create fallita" << std::endl;
+        rte_eal_cleanup();
+        return 1;
+    }
+
+    for (uint16_t port = 0; port < 2; port++) {
+        if (configure_dpdk_port(port, nb_queues, runtime_config().rx_queue_size,
+                                runtime_config().tx_queue_size, pool) < 0) {
+            std::cerr << "Configurazione della porta " << port << " fallita" << std::endl;
+            rte_eal_cleanup();
+            return 1;
+        }
+    }
+
+    DpdkWorkerArgs wargs{pool, create_agg_table(), create_steering(nb_queues), nb_queues};
+    std::cout << "Backend DPDK: " << nb_queues << " code per porta" << std::endl;
+
+    if (register_stats_telemetry() < 0)
+        std::cerr << "Registrazione del comando di telemetria fallita" << std::endl;
+    std::thread stats_thread = start_stats(nb_queues);
+
+    rte_eal_mp_remote_launch(dpdk_worker, &wargs, CALL_MAIN);
+    rte_eal_mp_wait_lcore();
+    if (stats_thread.joinable())
+        stats_thread.join();
+
+    for (uint16_t port = 0; port < 2; port++) {
+        rte_eth_dev_stop(port);
+        rte_eth_dev_close(port);
+    }
+    delete wargs.agg_table;
+    delete wargs.steering;
+    rte_eal_cleanup();
+    return 0;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    // Opzioni di configurazione prima del backend: vengono tolte da argv
+    if (!parse_config_args(runtime_config(), argc, argv))
+        return 1;
+    // Contesto SEAL costruito una volta sola, prima dei thread: gli HEContext degli lcore lo condividono
+    if (!init_seal_context(runtime_config()))
+        return 1;
+    print_config(runtime_config());
+
+    if (argc < 2) {
+        std::cerr << "Argomenti non validi: <afpacket|xdp|dpdk> ..." << std::endl;
+        return 1;
+    }
+
+    signal(SIGINT, handle_exit_signal);
+    signal(SIGTERM, handle_exit_signal);
+
+    std::string backend = argv[1];
+    int ret;
+    if (backend == "afpacket") {
+        ret = run_afpacket(argc, argv);
+#ifdef FWD_WITH_XDP
+    } else if (backend == "xdp") {
+        ret = run_xdp(argc, argv);
+#endif
+#ifdef FWD_WITH_DPDK
+    } else if (backend == "dpdk") {
+        ret = run_dpdk(argc, argv);
+#endif
+    } else {
+        std::cerr << "Backend non disponibile: " << backend << std::endl;
+        return 1;
+    }
+
+    std::cout << "Shutdown..." << std::endl;
+    print_he_benchmark();
+    print_stats_summary();
+    print_tenant_stats();
+    return ret;
+}
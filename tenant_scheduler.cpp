@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <arpa/inet.h>
+
+#include "tenant_scheduler.h"
+
+// Tenant che raccoglie quelli oltre max_tenants
+constexpr uint64_t OVERFLOW_TENANT = UINT64_MAX;
+
+// Contatori dei lcore già terminati, per chiave del tenant
+static std::mutex global_mtx;
+static std::map<uint64_t, TenantStats> global_stats;
+
+TenantScheduler::TenantScheduler(bool by_port, uint32_t quantum, uint32_t queue_len, uint32_t rate_limit,
+                                 uint32_t burst, uint32_t max_tenants)
+    : by_port(by_port), quantum(quantum), queue_len(queue_len), rate_limit(rate_limit), burst(burst),
+      max_tenants(max_tenants)
+{
+    // Niente riallocazioni (e spostamento delle code) all'arrivo di nuovi tenant
+    tenants.reserve(max_tenants + 1);
+}
+
+TenantScheduler::~TenantScheduler()
+{
+    std::lock_guard<std::mutex> lock(global_mtx);
+    for (const auto &t : tenants) {
+        TenantStats &g = global_stats[t.key];
+        g.enqueued += t.stats.enqueued;
+        g.processed += t.stats.processed;
+        g.bytes += t.stats.bytes;
+        g.drop_queue += t.stats.drop_queue;
+        g.drop_rate += t.stats.drop_rate;
+        g.max_depth = std::max(g.max_depth, t.stats.max_depth);
+    }
+}
+
+TenantScheduler::Tenant &TenantScheduler::tenant(const FlowRoute &route)
+{
+    uint64_t key = ((uint64_t)route.src_ip << 16) | (by_port ? route.src_port : 0);
+    auto it = index.find(key);
+    if (it != index.end())
+        return tenants[it->second];
+    if (tenants.size() >= max_tenants) {
+        key = OVERFLOW_TENANT;
+        it = index.find(key);
+        if (it != index.end())
+            return tenants[it->second];
+    }
+
+    index.emplace(key, tenants.size());
+    tenants.emplace_back();
+    Tenant &t = tenants.back();
+    t.key = key;
+    t.ring.resize(queue_len);
+    t.tokens = burst;
+    t.last_refill = std::chrono::steady_clock::now();
+    return t;
+}
+
+bool TenantScheduler::take_token(Tenant &t)
+{
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - t.last_refill).count();
+    t.last_refill = now;
+    t.tokens = std::min<double>(burst, t.tokens + elapsed * rate_limit);
+    if (t.tokens < 1)
+        return false;
+    t.tokens -= 1;
+    return true;
+}
+
+TenantScheduler::EnqueueResult TenantScheduler::enqueue(PendingMessage &msg)
+{
+    Tenant &t = tenant(msg.route);
+    // Prima la capacità: un messaggio scartato per coda piena non consuma token
+    if (t.count == queue_len) {
+        t.stats.drop_queue++;
+        return EnqueueResult::QueueFull;
+    }
+    if (rate_limit > 0 && !take_token(t)) {
+        t.stats.drop_rate++;
+        return EnqueueResult::RateLimited;
+    }
+
+    t.ring[(t.head + t.count) % queue_len] = std::move(msg);
+    t.count++;
+    queued++;
+    t.stats.enqueued++;
+    t.stats.max_depth = std::max(t.stats.max_depth, t.count);
+    if (!t.active) {
+        t.active = true;
+        active.push_back(&t - tenants.data());
+    }
+    return EnqueueResult::Queued;
+}
+
+bool TenantScheduler::dequeue(PendingMessage &msg)
+{
+    // Ad ogni turno il tenant in testa riceve quantum byte e viene servito finché il messaggio in testa
+    // alla sua coda ci sta nel deficit; poi passa in fondo. Un tenant che svuota la coda perde il deficit
+    while (!active.empty()) {
+        Tenant &t = tenants[active.front()];
+        if (!t.turn_started) {
+            t.deficit += quantum;
+            t.turn_started = true;
+        }
+
+        PendingMessage &head = t.ring[t.head];
+        uint64_t cost = head.result.data.size();
+        if (cost <= t.deficit) {
+            t.deficit -= cost;
+            msg = std::move(head);
+            t.head = (t.head + 1) % queue_len;
+            t.count--;
+            queued--;
+            t.stats.processed++;
+            t.stats.bytes += cost;
+            if (t.count == 0) {
+                t.deficit = 0;
+                t.turn_started = false;
+                t.active = false;
+                active.pop_front();
+            }
+            return true;
+        }
+
+        t.turn_started = false;
+        active.push_back(active.front());
+        active.pop_front();
+    }
+    return false;
+}
+
+void print_tenant_stats()
+{
+    std::lock_guard<std::mutex> lock(global_mtx);
+    if (global_stats.empty())
+        return;
+
+    std::cout << "Statistiche per tenant (" << global_stats.size() << "):" << std::endl;
+    for (const auto &entry : global_stats) {
+        const TenantStats &s = entry.second;
+        char name[32];
+        if (entry.first == OVERFLOW_TENANT) {
+            snprintf(name, sizeof(name), "altri");
+        } else {
+            struct in_addr addr;
+            addr.s_addr = (uint32_t)(entry.first >> 16);
+            uint16_t port = ntohs((uint16_t)entry.first);
+            if (port != 0)
+                snprintf(name, sizeof(name), "%s:%u", inet_ntoa(addr), port);
+            else
+                snprintf(name, sizeof(name), "%s", inet_ntoa(addr));
+        }
+        std::cout << "  " << name << ": accodati " << s.enqueued << ", elaborati " << s.processed
+                  << " (" << s.bytes << " byte), scartati coda piena " << s.drop_queue
+                  << ", oltre il rate " << s.drop_rate << ", coda max " << s.max_depth << std::endl;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef TENANT_SCHEDULER_H
+#define TENANT_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "aggregator.h"
+#include "packet_assembler.h"
+
+// Messaggio riassemblato in attesa dell'elaborazione omomorfica
+struct PendingMessage {
+    PacketAssembler::AssemblyResult result;
+    FlowRoute route{};
+    uint16_t out_port = 0;
+    uint16_t out_queue = 0;
+};
+
+// Contatori di un tenant
+struct TenantStats {
+    uint64_t enqueued = 0;       // Messaggi accodati
+    uint64_t processed = 0;      // Messaggi passati all'elaborazione omomorfica
+    uint64_t bytes = 0;          // Byte dei messaggi elaborati
+    uint64_t drop_queue = 0;     // Scartati con la coda del tenant piena
+    uint64_t drop_rate = 0;      // Scartati oltre il rate limit
+    uint32_t max_depth = 0;      // Coda più lunga osservata
+};
+
+// Code per tenant dei messaggi riassemblati, servite con deficit round robin verso lo stadio HE.
+// Il tenant è l'IP sorgente (con by_port anche la porta sorgente): un sender che manda più messaggi di
+// quanti il lcore riesca a elaborarne riempie solo la propria coda, e gli altri continuano ad avere la
+// loro quota. Il costo di un messaggio è la sua dimensione in byte, ogni turno di un tenant aggiunge
+// quantum byte al suo deficit. Con rate_limit > 0 ogni tenant ha anche un token bucket (messaggi/s,
+// fino a burst messaggi di fila). Oltre max_tenants i nuovi tenant condividono un'unica coda.
+// Una istanza per lcore (non thread-safe): alla distruzione i contatori vengono sommati a quelli del
+// processo (vedi print_tenant_stats)
+class TenantScheduler {
+public:
+    enum class EnqueueResult : uint8_t {
+        Queued,
+        QueueFull,    // Coda del tenant piena: messaggio scartato
+        RateLimited   // Tenant oltre il rate limit: messaggio scartato
+    };
+
+    TenantScheduler(bool by_port, uint32_t quantum, uint32_t queue_len, uint32_t rate_limit,
+                    uint32_t burst, uint32_t max_tenants);
+    ~TenantScheduler();
+
+    // Accoda il messaggio (spostato solo se Queued)
+    EnqueueResult enqueue(PendingMessage &msg);
+
+    // Prossimo messaggio secondo il DRR. Ritorna false se tutte le code sono vuote
+    bool dequeue(PendingMessage &msg);
+
+    // Messaggi in coda su tutti i tenant
+    size_t backlog() const { return queued; }
+
+private:
+    struct Tenant {
+        uint64_t key = 0;
+        std::vector<PendingMessage> ring;   // queue_len posti, riusati
+        uint32_t head = 0;
+        uint32_t count = 0;
+        uint64_t deficit = 0;
+        bool active = false;                // Nella lista dei tenant con messaggi in coda
+        bool turn_started = false;          // Quantum del turno corrente già aggiunto
+        double tokens = 0;
+        std::chrono::steady_clock::time_point last_refill;
+        TenantStats stats;
+    };
+
+    Tenant &tenant(const FlowRoute &route);
+    bool take_token(Tenant &t);
+
+    const bool by_port;
+    const uint32_t quantum;
+    const uint32_t queue_len;
+    const uint32_t rate_limit;
+    const uint32_t burst;
+    const uint32_t max_tenants;
+    std::vector<Tenant> tenants;
+    std::unordered_map<uint64_t, uint32_t> index;   // Chiave del tenant -> posizione in tenants
+    std::deque<uint32_t> active;                    // Tenant con messaggi in coda, in ordine di turno
+    size_t queued = 0;
+};
+
+// Stampa i contatori per tenant dei lcore terminati (a fine esecuzione)
+void print_tenant_stats();
+
+#endif
@@ -0,0 +1,67 @@
+// Programma XDP per il backend AF_XDP del forwarder (packet_io_xdp.cpp).
+// Redirige sulla socket AF_XDP della coda solo i frammenti di telemetria (UDP verso
+// BASE_PORT..BASE_PORT+N_PORTS-1), tutto il resto (ARP, SSH, ...) passa allo stack del kernel.
+//
+// Compilazione (fatta da CMake): clang -O2 -g -target bpf -c xdp_telemetry.bpf.c -o xdp_telemetry.bpf.o
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/in.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_endian.h>
+
+// Intervallo di porte UDP da redirigere, scritto dal forwarder dopo il caricamento (da runtime_config())
+struct port_range {
+    __u16 base_port;
+    __u16 n_ports;
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, 1);
+    __type(key, __u32);
+    __type(value, struct port_range);
+} port_range_map SEC(".maps");
+
+// Socket AF_XDP indicizzate per coda RX
+struct {
+    __uint(type, BPF_MAP_TYPE_XSKMAP);
+    __uint(max_entries, 64);
+    __type(key, __u32);
+    __type(value, __u32);
+} xsks_map SEC(".maps");
+
+SEC("xdp")
+int xdp_telemetry_redirect(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+
+    struct ethhdr *eth = data;
+    if ((void *)(eth + 1) > data_end || eth->h_proto != bpf_htons(ETH_P_IP))
+        return XDP_PASS;
+
+    struct iphdr *ip = (void *)(eth + 1);
+    if ((void *)(ip + 1) > data_end || ip->protocol != IPPROTO_UDP || ip->ihl < 5)
+        return XDP_PASS;
+
+    struct udphdr *udp = (void *)ip + ip->ihl * 4;
+    if ((void *)(udp + 1) > data_end)
+        return XDP_PASS;
+
+    __u32 key = 0;
+    struct port_range *range = bpf_map_lookup_elem(&port_range_map, &key);
+    if (!range)
+        return XDP_PASS;
+
+    __u16 dst_port = bpf_ntohs(udp->dest);
+    if (dst_port < range->base_port || dst_port >= range->base_port + range->n_ports)
+        return XDP_PASS;
+
+    // Se nessuna socket è associata alla coda il pacchetto va al kernel
+    return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+}
+
+char _license[] SEC("license") = "GPL";